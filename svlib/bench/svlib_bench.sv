@@ -0,0 +1,374 @@
+//=============================================================================
+//  @brief  Benchmarks of svlib's most heavily used operations
+//  @author Jonathan Bromley, Verilab (www.verilab.com)
+//=============================================================================
+//
+//                      svlib SystemVerilog Utilities Library
+//
+// @File: svlib_bench.sv
+//
+// Copyright 2014 Verilab, Inc.
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//=============================================================================
+//
+// Each benchmark is run at three input sizes, 100, 1000 and 10000 items,
+// all multiplied by +bench_scale=<k> (default 1). At each size, one
+// untimed run is followed by as many timed runs as fit in +bench_min_ms=<ms>
+// (default 200). One JSON object per benchmark and size is written to
+// +bench_out=<file> (default bench_results.jsonl), with fields
+//   bench, size, iters, total_ns, ns_per_iter, ns_per_item, tool, version
+// so that results from different runs, tools or svlib versions can be
+// compared by any script. +bench_only=<regex> runs only the benchmarks
+// whose names match the regex.
+//
+// The benchmarks make their input files in ./bench_work, which is removed
+// at the end of the run.
+//=============================================================================
+
+`include "svlib_macros.svh"
+
+package svlib_bench_pkg;
+
+  import svlib_pkg::*;
+  // For Obstack, to measure the cost of pool churn directly
+  import svlib_private_base_pkg::*;
+
+  localparam string WORK_DIR = "bench_work";
+
+  // Base class for all benchmarks. setup(n) makes the input for size n,
+  // run() is the operation that is timed, and teardown() tidies up.
+  virtual class Bench;
+    int n;
+    pure virtual function string name();
+    virtual function void setup(int n); this.n = n; endfunction
+    pure virtual function void run();
+    virtual function void teardown(); endfunction
+  endclass: Bench
+
+  //---------------------------------------------------------------------------
+  // Str
+
+  class BenchStrSplit extends Bench;
+    Str s;
+    function string name(); return "str_split"; endfunction
+    function void setup(int n);
+      qs fields;
+      super.setup(n);
+      for (int i=0; i<n; i++) fields.push_back($sformatf("field%0d", i));
+      s = Str::create(str_sjoin(fields, ","));
+    endfunction
+    function void run();
+      qs q = s.split(",");
+    endfunction
+  endclass: BenchStrSplit
+
+  class BenchStrFirst extends Bench;
+    Str s;
+    function string name(); return "str_first"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      s = Str::create({str_repeat("abcdefgh", n), "needle"});
+    endfunction
+    function void run();
+      void'(s.first("needle"));
+    endfunction
+  endclass: BenchStrFirst
+
+  class BenchStrReplace extends Bench;
+    string text;
+    Str    s;
+    function string name(); return "str_replace"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      text = str_repeat("abcdefgh", n);
+      s = Str::create();
+    endfunction
+    function void run();
+      s.set(text);
+      for (int i=0; i<n; i++) s.replace("XY", 8*i+2, 2);
+    endfunction
+  endclass: BenchStrReplace
+
+  //---------------------------------------------------------------------------
+  // Regex
+
+  class BenchRegexTest extends Bench;
+    string lines[$];
+    Regex  re;
+    function string name(); return "regex_test"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      re = Regex::create("^([[:alpha:]_]+)[[:space:]]*=[[:space:]]*([0-9]+)$");
+      lines.delete();
+      for (int i=0; i<n; i++)
+        lines.push_back((i%4) ? $sformatf("key_%0d = %0d", i, i) : "# comment");
+    endfunction
+    function void run();
+      foreach (lines[i]) begin
+        re.setStrContents(lines[i]);
+        void'(re.retest(0));
+      end
+    endfunction
+  endclass: BenchRegexTest
+
+  class BenchRegexSubstAll extends Bench;
+    string text;
+    Regex  re;
+    function string name(); return "regex_substAll"; endfunction
+    function void setup(int n);
+      qs words;
+      super.setup(n);
+      re = Regex::create("[0-9]+");
+      for (int i=0; i<n; i++) words.push_back($sformatf("word %0d", i));
+      text = str_sjoin(words, ", ");
+    endfunction
+    function void run();
+      re.setStrContents(text);
+      void'(re.substAll("<$0>"));
+    endfunction
+  endclass: BenchRegexSubstAll
+
+  class BenchRegexSplit extends Bench;
+    Regex re;
+    function string name(); return "regex_split"; endfunction
+    function void setup(int n);
+      qs fields;
+      super.setup(n);
+      for (int i=0; i<n; i++) fields.push_back($sformatf("f%0d", i));
+      re = Regex::create("[[:space:]]*[,;][[:space:]]*");
+      re.setStrContents(str_sjoin(fields, " , "));
+    endfunction
+    function void run();
+      qs q = re.split();
+    endfunction
+  endclass: BenchRegexSplit
+
+  //---------------------------------------------------------------------------
+  // scanVerilogInt
+
+  class BenchScanVerilogInt extends Bench;
+    string literals[$];
+    function string name(); return "scanVerilogInt"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      literals.delete();
+      for (int i=0; i<n; i++) begin
+        int v = i & 16'h7FFF;
+        case (i%4)
+          0: literals.push_back($sformatf("%0d", v));
+          1: literals.push_back($sformatf("32'h%0h", v));
+          2: literals.push_back($sformatf("'b%0b", v));
+          3: literals.push_back($sformatf("16'sd%0d", v));
+        endcase
+      end
+    endfunction
+    function void run();
+      logic signed [63:0] v;
+      foreach (literals[i]) void'(scanVerilogInt(literals[i], v));
+    endfunction
+  endclass: BenchScanVerilogInt
+
+  //---------------------------------------------------------------------------
+  // Cfg
+
+  // n keys, ten to a section
+  function automatic void writeIniFile(string path, int n);
+    qs lines;
+    for (int i=0; i<n; i++) begin
+      if (i%10 == 0) lines.push_back($sformatf("[section%0d]", i/10));
+      lines.push_back($sformatf("key%0d = value %0d", i%10, i));
+    end
+    file_writeAll(path, {str_sjoin(lines, "\n"), "\n"});
+  endfunction
+
+  class BenchIniLoad extends Bench;
+    string     path;
+    cfgFileINI fi;
+    function string name(); return "ini_load"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      path = $sformatf("%s/load_%0d.ini", WORK_DIR, n);
+      writeIniFile(path, n);
+      fi = cfgFileINI::create("bench");
+    endfunction
+    function void run();
+      cfgNode root;
+      void'(fi.openR(path));
+      root = fi.deserialize();
+      void'(fi.close());
+    endfunction
+  endclass: BenchIniLoad
+
+  class BenchIniSave extends Bench;
+    string     path;
+    cfgFileINI fi;
+    cfgNode    root;
+    function string name(); return "ini_save"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      path = $sformatf("%s/save_%0d.ini", WORK_DIR, n);
+      writeIniFile(path, n);
+      fi = cfgFileINI::create("bench");
+      void'(fi.openR(path));
+      root = fi.deserialize();
+      void'(fi.close());
+    endfunction
+    function void run();
+      void'(fi.openW(path));
+      void'(fi.serialize(root));
+      void'(fi.close());
+    endfunction
+  endclass: BenchIniSave
+
+  class BenchCfgLookup extends Bench;
+    cfgNodeMap root;
+    string     paths[$];
+    function string name(); return "cfg_lookup"; endfunction
+    function void setup(int n);
+      cfgNodeMap section;
+      super.setup(n);
+      root = cfgNodeMap::create("root");
+      paths.delete();
+      for (int i=0; i<n; i++) begin
+        if (i%10 == 0) begin
+          section = cfgNodeMap::create($sformatf("section%0d", i/10));
+          root.addNode(section);
+        end
+        section.addNode(cfgScalarInt::createNode($sformatf("key%0d", i%10), i));
+        paths.push_back($sformatf("section%0d.key%0d", i/10, i%10));
+      end
+    endfunction
+    function void run();
+      foreach (paths[i]) void'(root.lookup(paths[i]));
+    endfunction
+  endclass: BenchCfgLookup
+
+  //---------------------------------------------------------------------------
+  // Sys
+
+  class BenchFileGlob extends Bench;
+    string dir;
+    function string name(); return "sys_fileGlob"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      dir = $sformatf("%s/glob_%0d", WORK_DIR, n);
+      void'($system({"mkdir -p ", dir}));
+      for (int i=0; i<n; i++) file_writeAll($sformatf("%s/file%0d.txt", dir, i), "");
+    endfunction
+    function void run();
+      qs q = sys_fileGlob({dir, "/file*.txt"});
+    endfunction
+  endclass: BenchFileGlob
+
+  //---------------------------------------------------------------------------
+  // Object pools
+
+  class BenchObstackChurn extends Bench;
+    Str held[];
+    function string name(); return "obstack_churn"; endfunction
+    function void setup(int n);
+      super.setup(n);
+      held = new[n];
+    endfunction
+    function void run();
+      foreach (held[i]) held[i] = Str::create("churn");
+      foreach (held[i]) Obstack#(Str)::relinquish(held[i]);
+    endfunction
+  endclass: BenchObstackChurn
+
+  //---------------------------------------------------------------------------
+  // Runner
+
+  class BenchRunner;
+
+    Bench   benches[$];
+    int     scale  = 1;
+    longint minNs  = 200_000_000;
+    string  only   = "";
+    string  outPath = "bench_results.jsonl";
+    qs      results;
+
+    function new();
+      int minMs;
+      void'($value$plusargs("bench_scale=%d", scale));
+      if ($value$plusargs("bench_min_ms=%d", minMs)) minNs = longint'(minMs) * 1_000_000;
+      void'($value$plusargs("bench_only=%s", only));
+      void'($value$plusargs("bench_out=%s", outPath));
+      if (scale < 1) scale = 1;
+      begin
+        BenchStrSplit       b0  = new;  BenchStrFirst      b1  = new;
+        BenchStrReplace     b2  = new;  BenchRegexTest     b3  = new;
+        BenchRegexSubstAll  b4  = new;  BenchRegexSplit    b5  = new;
+        BenchScanVerilogInt b6  = new;  BenchIniLoad       b7  = new;
+        BenchIniSave        b8  = new;  BenchCfgLookup     b9  = new;
+        BenchFileGlob       b10 = new;  BenchObstackChurn  b11 = new;
+        benches = '{b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11};
+      end
+    endfunction
+
+    function void measure(Bench b, int n);
+      longint iters = 0;
+      longint t0, total;
+      b.setup(n);
+      b.run();  // warm up caches and pools
+      t0 = sys_clockNsTime(sysCLOCK_MONOTONIC);
+      do begin
+        b.run();
+        iters++;
+        total = sys_clockNsTime(sysCLOCK_MONOTONIC) - t0;
+      end while (total < minNs);
+      b.teardown();
+      results.push_back($sformatf(
+        "{\"bench\":\"%s\",\"size\":%0d,\"iters\":%0d,\"total_ns\":%0d,\"ns_per_iter\":%0.1f,\"ns_per_item\":%0.3f,\"tool\":\"%s\",\"version\":\"%s\"}",
+        b.name(), n, iters, total, real'(total)/iters, real'(total)/iters/n,
+        Simulator::getToolName(), Simulator::getToolVersion()));
+      $display("%-16s %8d %10d iters %14.1f ns/iter %10.3f ns/item",
+               b.name(), n, iters, real'(total)/iters, real'(total)/iters/n);
+    endfunction
+
+    function void runAll();
+      Regex filter = (only == "") ? null : Regex::create(only);
+      Str   benchName;
+      int   found;
+      void'($system({"mkdir -p ", WORK_DIR}));
+      foreach (benches[i]) begin
+        if (filter != null) begin
+          benchName = Str::create(benches[i].name());
+          found     = filter.test(benchName);
+          Obstack#(Str)::relinquish(benchName);
+          if (!found) continue;
+        end
+        for (int n = 100; n <= 10000; n *= 10) measure(benches[i], n * scale);
+      end
+      void'($system({"rm -rf ", WORK_DIR}));
+      file_writeAll(outPath, {str_sjoin(results, "\n"), "\n"});
+      $display("%0d results written to %s", results.size(), outPath);
+    endfunction
+
+  endclass: BenchRunner
+
+endpackage: svlib_bench_pkg
+
+
+module svlib_bench;
+
+  import svlib_bench_pkg::*;
+
+  initial begin
+    BenchRunner runner = new();
+    runner.runAll();
+    $finish;
+  end
+
+endmodule
@@ -16,6 +16,10 @@ module cmdline;
     foreach (cmdOpts[i]) begin
       $display("  [%2d] : \"%s\"", i, cmdOpts[i]);
     end
+    $display("Plusarg +seed= as int : %0d", Plusargs::getInt("seed", -1));
+    $display("Plusarg +define+ list : %p", Plusargs::getList("define"));
+    $display("Unused plusargs       : %p", Plusargs::unused());
+    $display("Plusargs as DOM:\n%s", Plusargs::toDOM().sformat(1));
   end
   
 endmodule
@@ -32,13 +32,24 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <glob.h>
+#include <dirent.h>
+#include <fnmatch.h>
 #include <time.h>
 #include <regex.h>
 #include <assert.h>
+#include <pthread.h>
+#ifndef SVLIB_NO_ZLIB
+#include <zlib.h>
+#endif
 
 #include <veriuser.h>
 #include <vpi_user.h>
@@ -47,6 +58,20 @@
 #define STRINGIFY(x) MACROHASH(x)
 #define MACROHASH(x) #x
 
+/*
+ * Storage class for state that each thread must have its own copy of.
+ * Strings returned to SV live in buffers like this until the calling
+ * thread's next call that returns a string of the same kind, so that
+ * the DPI functions can be called concurrently by a multi-threaded
+ * simulator. State that must be shared (the regex cache, ProfRegion
+ * statistics) is protected by a mutex instead.
+ */
+#if __STDC_VERSION__ >= 201112L
+#define SVLIB_THREAD_LOCAL _Thread_local
+#else
+#define SVLIB_THREAD_LOCAL __thread
+#endif
+
 #define SVLIB_STRING_BUFFER_START_SIZE       (256)
 #define SVLIB_STRING_BUFFER_LONGEST_PATHNAME (8192)
 
@@ -56,8 +81,8 @@ extern "C" {
 
 #include "../svlib_shared_c_sv.h"
 
-static char*  libStringBuffer = NULL;
-static size_t libStringBufferSize = 0;
+static SVLIB_THREAD_LOCAL char*  libStringBuffer = NULL;
+static SVLIB_THREAD_LOCAL size_t libStringBufferSize = 0;
 
 /*--------------------------------------------------------------------------
  * FOR INTERNAL USE BY SVLIB ONLY:
@@ -100,6 +125,46 @@ static size_t getLibStringBufferSize() {
   }
 }
 
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Growable character buffer, for building up a result string piece by
+ * piece in amortized linear time. The content is always null-terminated
+ * so that it can be returned directly to SV as a string.
+ */
+typedef struct strBuf {
+  char   * buf;
+  size_t   len;
+  size_t   size;
+} strBuf_s, *strBuf_p;
+
+static int32_t strBufReserve(strBuf_p sb, size_t extra) {
+  size_t newSize;
+  char * p;
+  if (sb->len + extra + 1 <= sb->size) return 0;
+  newSize = sb->size ? sb->size : SVLIB_STRING_BUFFER_START_SIZE;
+  while (newSize < sb->len + extra + 1) newSize *= 2;
+  p = realloc(sb->buf, newSize);
+  if (p == NULL) return ENOMEM;
+  p[sb->len] = 0;
+  sb->buf  = p;
+  sb->size = newSize;
+  return 0;
+}
+
+static int32_t strBufAppend(strBuf_p sb, const char *s, size_t n) {
+  if (strBufReserve(sb, n)) return ENOMEM;
+  memcpy(sb->buf + sb->len, s, n);
+  sb->len += n;
+  sb->buf[sb->len] = 0;
+  return 0;
+}
+
+static void strBufClear(strBuf_p sb) {
+  sb->len = 0;
+  if (sb->buf != NULL) sb->buf[0] = 0;
+}
+
 /*--------------------------------------------------------------------------
  * FOR INTERNAL USE BY SVLIB ONLY:
  *--------------------------------------------------------------------------
@@ -172,11 +237,156 @@ extern int32_t svlib_dpi_imported_saBufNext(void **h, const char **s) {
 }
 
 
+/*-------------------------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_saBufNextBatch(
+ *                              inout chandle h, output string ss[], output int n);
+ *-------------------------------------------------------------------------------
+ * Like saBufNext, but serves up as many strings as will fit in ss[] at once,
+ * returning the number of strings delivered in n. The C-side storage is
+ * freed, and the chandle set to null, on the first call that finds no more
+ * strings (which may therefore return n==0), because the strings most
+ * recently delivered must remain valid until SV has copied them.
+ */
+extern int32_t svlib_dpi_imported_saBufNextBatch(void **h, const svOpenArrayHandle ss, int32_t *n) {
+  saBuf_p p;
+  int     i, lo, size;
+  *n = 0;
+  if (*h == NULL) {
+    return 0;
+  }
+  p = (saBuf_p)(*h);
+  if (p->sanity_check != p) {
+    return ENOMEM;
+  }
+  if (*(p->scan) == NULL) {
+    *h = NULL;
+    if (p->freeFunc != NULL) {
+      (*(p->freeFunc))(p);
+    }
+    return 0;
+  }
+  lo   = svLow(ss, 1);
+  size = svSize(ss, 1);
+  for (i=0; (i<size) && (*(p->scan) != NULL); i++) {
+    *(const char**)svGetArrElemPtr1(ss, lo+i) = *(p->scan);
+    p->scan++;
+  }
+  *n = i;
+  return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Growable list of strings, all packed into a single character buffer,
+ * suitable for handing back to SV through a saBuf. Build it with
+ * strListAppend, then strListFinish makes the NULL-terminated array of
+ * pointers that saBufNext expects. The saBuf's freeFunc releases it all.
+ */
+typedef struct strList {
+  char    * chars;       /* all the strings, each with its terminating null */
+  size_t    nChars;
+  size_t    charsSize;
+  size_t  * offsets;     /* start of each string within chars[]             */
+  size_t    nStrs;
+  size_t    offsetsSize;
+  char   ** ptrs;        /* NULL-terminated array built by strListFinish    */
+} strList_s, *strList_p;
+
+static void strList_freeFunc(saBuf_p p) {
+  strList_p sl;
+  if (p==NULL) return;
+  sl = (strList_p)(p->pAppData);
+  free(sl->chars);
+  free(sl->offsets);
+  free(sl->ptrs);
+  free(sl);
+  free(p);
+}
+
+static int32_t strListCreate(saBuf_p *created) {
+  int32_t   result;
+  strList_p sl;
+  result = saBufCreate(sizeof(strList_s), strList_freeFunc, created);
+  if (result) return result;
+  sl = (strList_p)((*created)->pAppData);
+  memset(sl, 0, sizeof(strList_s));
+  return 0;
+}
+
+static int32_t strListAppend(saBuf_p sa, const char *s, size_t n) {
+  strList_p sl = (strList_p)(sa->pAppData);
+  if (sl->nStrs >= sl->offsetsSize) {
+    size_t  newSize = sl->offsetsSize ? 2*sl->offsetsSize : 64;
+    size_t *p = realloc(sl->offsets, newSize * sizeof(size_t));
+    if (p == NULL) return ENOMEM;
+    sl->offsets     = p;
+    sl->offsetsSize = newSize;
+  }
+  if (sl->nChars + n + 1 > sl->charsSize) {
+    size_t newSize = sl->charsSize ? 2*sl->charsSize : SVLIB_STRING_BUFFER_START_SIZE;
+    char  *p;
+    while (newSize < sl->nChars + n + 1) newSize *= 2;
+    p = realloc(sl->chars, newSize);
+    if (p == NULL) return ENOMEM;
+    sl->chars     = p;
+    sl->charsSize = newSize;
+  }
+  sl->offsets[sl->nStrs++] = sl->nChars;
+  memcpy(sl->chars + sl->nChars, s, n);
+  sl->nChars += n;
+  sl->chars[sl->nChars++] = 0;
+  return 0;
+}
+
+/* Remove the most recently appended string */
+static void strListPop(saBuf_p sa) {
+  strList_p sl = (strList_p)(sa->pAppData);
+  if (sl->nStrs == 0) return;
+  sl->nStrs--;
+  sl->nChars = sl->offsets[sl->nStrs];
+}
+
+/* Length of a string in the list */
+static size_t strListLen(saBuf_p sa, size_t i) {
+  strList_p sl = (strList_p)(sa->pAppData);
+  return strlen(sl->chars + sl->offsets[i]);
+}
+
+static size_t strListCount(saBuf_p sa) {
+  return ((strList_p)(sa->pAppData))->nStrs;
+}
+
+static int32_t strListFinish(saBuf_p sa) {
+  strList_p sl = (strList_p)(sa->pAppData);
+  size_t    i;
+  sl->ptrs = malloc((sl->nStrs + 1) * sizeof(char*));
+  if (sl->ptrs == NULL) return ENOMEM;
+  for (i=0; i<sl->nStrs; i++) {
+    sl->ptrs[i] = sl->chars + sl->offsets[i];
+  }
+  sl->ptrs[sl->nStrs] = NULL;
+  sa->scan = sl->ptrs;
+  return 0;
+}
+
+#define ARGV_STACK_PTR_SIZE 32
+
+/*
+ * State of a walk over the command line by getVlogInfoNext, kept
+ * in the handle rather than in statics so that each caller has its own.
+ */
+typedef struct vlogInfoIter {
+  char ** argv_stack[ARGV_STACK_PTR_SIZE];
+  int     argv_stack_ptr;
+} vlogInfoIter_s, *vlogInfoIter_p;
+
 /*-------------------------------------------------------------------------------
  * import "DPI-C" function chandle svlib_dpi_imported_getVlogInfo(
  *                              output string product, output string version);
  *-------------------------------------------------------------------------------
  * Function to set up the results of vpi_get_vlog_info() ready for consumption.
+ * The handle is freed by getVlogInfoNext when it reaches the end.
  *-------------------------------------------------------------------------------
  */
 
@@ -186,6 +396,7 @@ extern void * svlib_dpi_imported_getVlogInfo(
     ) {
   int             status;
   s_vpi_vlog_info info;
+  vlogInfoIter_p  it;
 
   /* Ensure result values are zero for easy error handling */
   *version = NULL;
@@ -200,13 +411,15 @@ extern void * svlib_dpi_imported_getVlogInfo(
      */
     return NULL;
   }
+  it = malloc(sizeof(vlogInfoIter_s));
+  if (it == NULL) return NULL;
+  it->argv_stack[0]  = (char**)info.argv;
+  it->argv_stack_ptr = 0;
   *version = info.version;
   *product = info.product;
-  return (void*) info.argv;
+  return (void*) it;
 }
 
-#define ARGV_STACK_PTR_SIZE 32
-
 /*-------------------------------------------------------------------------------
  * import "DPI-C" function string svlib_dpi_imported_getVlogInfoNext(inout chandle hnd);
  *-------------------------------------------------------------------------------
@@ -221,58 +434,53 @@ extern void * svlib_dpi_imported_getVlogInfo(
  */
 
 extern const char * svlib_dpi_imported_getVlogInfoNext (void** info_argv) {
-  static char*** argv_stack = NULL;
-  static int argv_stack_ptr = 0; // stack ptr
+  vlogInfoIter_p it = (vlogInfoIter_p)(*info_argv);
+  char        ***argv_stack;
 
-  if(argv_stack == NULL)
-  {
-    argv_stack = (char***) malloc (sizeof(char**)*ARGV_STACK_PTR_SIZE);
-    argv_stack[0] = (char**)*info_argv;
-  }
+  if (it == NULL) return NULL;
+  argv_stack = it->argv_stack;
 
   // until we have returned a value
   while (1)
   {
     // at end of current array?, pop stack
-    if (*argv_stack[argv_stack_ptr]  == NULL)
+    if (*argv_stack[it->argv_stack_ptr]  == NULL)
     {
       // stack empty?
-      if (argv_stack_ptr == 0)
+      if (it->argv_stack_ptr == 0)
       {
-        // reset stack for next time
-        argv_stack = NULL;
-        argv_stack_ptr = 0;
-        // return completion
+        // release the walk's state and return completion
+        free(it);
         *info_argv = NULL;
         return NULL;
       }
       // pop stack
-      --argv_stack_ptr;
+      --it->argv_stack_ptr;
       continue;
     }
     else
     {
       // check for -f indicating pointer to new array
-      if(0==strcmp(*argv_stack[argv_stack_ptr], "-f") ||
-         0==strcmp(*argv_stack[argv_stack_ptr], "-F") )
+      if(0==strcmp(*argv_stack[it->argv_stack_ptr], "-f") ||
+         0==strcmp(*argv_stack[it->argv_stack_ptr], "-F") )
       {
         // bump past -f at current level
-        ++argv_stack[argv_stack_ptr];
+        ++argv_stack[it->argv_stack_ptr];
         // push -f array argument onto stack
-        argv_stack[argv_stack_ptr+1] = (char **)*argv_stack[argv_stack_ptr];
+        argv_stack[it->argv_stack_ptr+1] = (char **)*argv_stack[it->argv_stack_ptr];
         // bump past -f argument at current level
-        ++argv_stack[argv_stack_ptr];
+        ++argv_stack[it->argv_stack_ptr];
         // update stack pointer
-        ++argv_stack_ptr;
+        ++it->argv_stack_ptr;
         // skip over filename string at start of new -f argument
-        ++argv_stack[argv_stack_ptr];
-        assert(argv_stack_ptr < ARGV_STACK_PTR_SIZE);
+        ++argv_stack[it->argv_stack_ptr];
+        assert(it->argv_stack_ptr < ARGV_STACK_PTR_SIZE);
       }
       else
       {
         // return current and move to next
-        char *r = *argv_stack[argv_stack_ptr];
-        ++argv_stack[argv_stack_ptr];
+        char *r = *argv_stack[it->argv_stack_ptr];
+        ++argv_stack[it->argv_stack_ptr];
         return r;
       }
     }
@@ -284,8 +492,20 @@ extern const char * svlib_dpi_imported_getVlogInfoNext (void** info_argv) {
  * import "DPI-C" function string svlib_dpi_imported_getCErrStr(input int errnum);
  *-------------------------------------------------------------------
  */
+static pthread_mutex_t strErrorLock = PTHREAD_MUTEX_INITIALIZER;
+static SVLIB_THREAD_LOCAL char strErrorResult[256];
+
+/* strerror() may use a static buffer, so copy its result under a lock */
+static char* svlibStrError(int errnum) {
+  pthread_mutex_lock(&strErrorLock);
+  strncpy(strErrorResult, strerror(errnum), sizeof(strErrorResult)-1);
+  strErrorResult[sizeof(strErrorResult)-1] = 0;
+  pthread_mutex_unlock(&strErrorLock);
+  return strErrorResult;
+}
+
 extern const char* svlib_dpi_imported_getCErrStr(int32_t errnum) {
-  return strerror(errnum);
+  return svlibStrError(errnum);
 }
 
 /*----------------------------------------------------------------
@@ -312,8 +532,9 @@ extern int32_t svlib_dpi_imported_getcwd(char ** p_result) {
         bSize *= 2;
       }
     } else {
-      *p_result = strerror(errno);
-      return errno;
+      int err = errno;
+      *p_result = svlibStrError(err);
+      return err;
     }
   }
 }
@@ -334,6 +555,356 @@ extern int32_t svlib_dpi_imported_getenv(char *envVar, char ** p_result) {
   }
 }
 
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Pathname support. Every distinct path component is interned: it is
+ * stored once, for the life of the process, in a table shared by all
+ * threads, and a Pathname holds only the components' ids. Ids 0, 1
+ * and 2 are always "", "." and ".." respectively.
+ */
+#define PATHCOMP_EMPTY  0
+#define PATHCOMP_DOT    1
+#define PATHCOMP_DOTDOT 2
+
+static pthread_mutex_t pathCompLock     = PTHREAD_MUTEX_INITIALIZER;
+static char         ** pathComps        = NULL;  /* id -> component */
+static int32_t         pathCompCount    = 0;
+static int32_t         pathCompMax      = 0;
+static int32_t       * pathCompHash     = NULL;  /* open addressing: id, or -1 */
+static size_t          pathCompHashSize = 0;     /* always a power of 2 */
+
+static size_t pathCompHashOf(const char *s, size_t len) {
+  size_t h = 2166136261u;
+  while (len--) h = (h ^ (unsigned char)(*s++)) * 16777619u;
+  return h;
+}
+
+static int32_t pathCompInternLocked(const char *s, size_t len);
+
+static int32_t pathCompRehashLocked(size_t newSize) {
+  int32_t *h = malloc(newSize * sizeof(int32_t));
+  int32_t  id;
+  if (h == NULL) return ENOMEM;
+  memset(h, 0xFF, newSize * sizeof(int32_t));
+  for (id=0; id<pathCompCount; id++) {
+    size_t i = pathCompHashOf(pathComps[id], strlen(pathComps[id])) & (newSize-1);
+    while (h[i] >= 0) i = (i+1) & (newSize-1);
+    h[i] = id;
+  }
+  free(pathCompHash);
+  pathCompHash     = h;
+  pathCompHashSize = newSize;
+  return 0;
+}
+
+/* Returns the id of the component s[0:len-1], adding it if it is new; -1 if out of memory */
+static int32_t pathCompInternLocked(const char *s, size_t len) {
+  size_t i;
+  char  *copy;
+  if (pathCompHashSize == 0) {
+    if (pathCompRehashLocked(1024)) return -1;
+    if ((pathCompInternLocked("",   0) != PATHCOMP_EMPTY) ||
+        (pathCompInternLocked(".",  1) != PATHCOMP_DOT)   ||
+        (pathCompInternLocked("..", 2) != PATHCOMP_DOTDOT)) return -1;
+  }
+  i = pathCompHashOf(s, len) & (pathCompHashSize-1);
+  while (pathCompHash[i] >= 0) {
+    const char *c = pathComps[pathCompHash[i]];
+    if ((strncmp(c, s, len) == 0) && (c[len] == 0)) return pathCompHash[i];
+    i = (i+1) & (pathCompHashSize-1);
+  }
+  if (pathCompCount == pathCompMax) {
+    int32_t newMax = pathCompMax ? 2*pathCompMax : 1024;
+    char  **p      = realloc(pathComps, newMax * sizeof(char*));
+    if (p == NULL) return -1;
+    pathComps   = p;
+    pathCompMax = newMax;
+  }
+  copy = malloc(len + 1);
+  if (copy == NULL) return -1;
+  memcpy(copy, s, len);
+  copy[len] = 0;
+  pathComps[pathCompCount] = copy;
+  pathCompHash[i] = pathCompCount;
+  pathCompCount++;
+  /* Keep the table at most half full */
+  if (2 * (size_t)pathCompCount > pathCompHashSize) {
+    if (pathCompRehashLocked(2 * pathCompHashSize)) return -1;
+  }
+  return pathCompCount - 1;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_pathSplit(
+ *                            input  string path,
+ *                            output int    ids[],
+ *                            output int    n,
+ *                            output int    absolute);
+ *----------------------------------------------------------------
+ * Split path at '/', ignoring empty components, and intern each
+ * component. ids[] must have at least (strlen(path)+1)/2 elements.
+ * Returns 0, or ENOMEM.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_pathSplit(
+    const char             *path,
+    const svOpenArrayHandle ids,
+    int32_t                *n,
+    int32_t                *absolute
+  ) {
+  int32_t     size = svSize(ids, 1);
+  int32_t     lo   = svLow(ids, 1);
+  int32_t     err  = 0;
+  const char *p    = path;
+  *n        = 0;
+  *absolute = (*p == '/');
+  pthread_mutex_lock(&pathCompLock);
+  while (*p) {
+    const char *e;
+    int32_t     id;
+    while (*p == '/') p++;
+    if (*p == 0) break;
+    for (e = p; *e && (*e != '/'); e++) ;
+    if (*n >= size) {
+      err = ERANGE;
+      break;
+    }
+    id = pathCompInternLocked(p, e-p);
+    if (id < 0) {
+      err = ENOMEM;
+      break;
+    }
+    *(int32_t*)svGetArrElemPtr1(ids, lo + (*n)++) = id;
+    p = e;
+  }
+  pthread_mutex_unlock(&pathCompLock);
+  return err;
+}
+
+static SVLIB_THREAD_LOCAL strBuf_s pathResult = {NULL, 0, 0};
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function string svlib_dpi_imported_pathJoin(
+ *                            input  int ids[],
+ *                            input  int first,
+ *                            input  int last);
+ *----------------------------------------------------------------
+ * Join components ids[first..last] with '/'. last is clipped to
+ * the end of ids[].
+ *----------------------------------------------------------------
+ */
+extern const char *svlib_dpi_imported_pathJoin(
+    const svOpenArrayHandle ids,
+    int32_t                 first,
+    int32_t                 last
+  ) {
+  int32_t size = svSize(ids, 1);
+  int32_t lo   = svLow(ids, 1);
+  int32_t i;
+  strBufClear(&pathResult);
+  if (last >= size) last = size - 1;
+  if (first < 0) first = 0;
+  pthread_mutex_lock(&pathCompLock);
+  for (i = first; i <= last; i++) {
+    int32_t     id = *(int32_t*)svGetArrElemPtr1(ids, lo+i);
+    const char *c  = ((id >= 0) && (id < pathCompCount)) ? pathComps[id] : "";
+    if (((i > first) && strBufAppend(&pathResult, "/", 1)) ||
+        strBufAppend(&pathResult, c, strlen(c))) break;
+  }
+  pthread_mutex_unlock(&pathCompLock);
+  return (pathResult.buf == NULL) ? "" : pathResult.buf;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function string svlib_dpi_imported_pathComponent(
+ *                            input  int id);
+ *----------------------------------------------------------------
+ */
+extern const char *svlib_dpi_imported_pathComponent(int32_t id) {
+  const char *c = "";
+  pthread_mutex_lock(&pathCompLock);
+  if ((id >= 0) && (id < pathCompCount)) c = pathComps[id];
+  pthread_mutex_unlock(&pathCompLock);
+  return c;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_pathNormalize(
+ *                            inout  int ids[],
+ *                            input  int absolute);
+ *----------------------------------------------------------------
+ * Lexically remove "." components, and ".." components along with
+ * the component before them. A ".." with nothing before it is kept
+ * in a relative path, and dropped at the root of an absolute one.
+ * Works in place; returns the number of components that remain.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_pathNormalize(
+    const svOpenArrayHandle ids,
+    int32_t                 absolute
+  ) {
+  int32_t  size = svSize(ids, 1);
+  int32_t  lo   = svLow(ids, 1);
+  int32_t  i, n = 0;
+  for (i=0; i<size; i++) {
+    int32_t id = *(int32_t*)svGetArrElemPtr1(ids, lo+i);
+    if (id == PATHCOMP_DOT) continue;
+    if (id == PATHCOMP_DOTDOT) {
+      if ((n > 0) && (*(int32_t*)svGetArrElemPtr1(ids, lo+n-1) != PATHCOMP_DOTDOT)) {
+        n--;
+        continue;
+      }
+      if (absolute) continue;
+    }
+    *(int32_t*)svGetArrElemPtr1(ids, lo + n++) = id;
+  }
+  return n;
+}
+
+/*
+ * Lexically normalized components of a path, as spans of the string.
+ */
+typedef struct pathSpans {
+  const char  ** start;
+  size_t       * len;
+  size_t         n;
+  int            absolute;
+} pathSpans_s, *pathSpans_p;
+
+static void pathSpansFree(pathSpans_p ps) {
+  free(ps->start);
+  free(ps->len);
+}
+
+static int32_t pathSpansOf(const char *path, pathSpans_p ps) {
+  size_t      max = strlen(path)/2 + 1;
+  const char *p   = path;
+  ps->n        = 0;
+  ps->absolute = (*p == '/');
+  ps->start    = malloc(max * sizeof(char*));
+  ps->len      = malloc(max * sizeof(size_t));
+  if ((ps->start == NULL) || (ps->len == NULL)) {
+    pathSpansFree(ps);
+    return ENOMEM;
+  }
+  while (*p) {
+    const char *e;
+    while (*p == '/') p++;
+    if (*p == 0) break;
+    for (e = p; *e && (*e != '/'); e++) ;
+    if ((e-p == 1) && (p[0] == '.')) {
+      /* drop it */
+    } else if ((e-p == 2) && (p[0] == '.') && (p[1] == '.') &&
+               !((ps->n > 0) && (ps->len[ps->n-1] == 2) && (strncmp(ps->start[ps->n-1], "..", 2) == 0))) {
+      if (ps->n > 0) {
+        ps->n--;
+      } else if (!ps->absolute) {
+        ps->start[ps->n] = p;
+        ps->len[ps->n++] = 2;
+      }
+    } else {
+      ps->start[ps->n] = p;
+      ps->len[ps->n++] = e-p;
+    }
+    p = e;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_pathRelative(
+ *                            input  string path,
+ *                            input  string base,
+ *                            output string result);
+ *----------------------------------------------------------------
+ * Find a relative path that leads from directory base to path,
+ * after normalizing both lexically; "." if they are the same.
+ * If only one of them is absolute, or base starts with ".." (after
+ * normalization), both are first made absolute using the working
+ * directory. Returns 0 or an errno value.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_pathRelative(
+    const char  *path,
+    const char  *base,
+    const char **result
+  ) {
+  pathSpans_s pp, bp;
+  strBuf_s    absPath = {NULL, 0, 0}, absBase = {NULL, 0, 0};
+  size_t      common, i;
+  int32_t     err;
+
+  *result = "";
+  if ((err = pathSpansOf(path, &pp))) return err;
+  if ((err = pathSpansOf(base, &bp))) {
+    pathSpansFree(&pp);
+    return err;
+  }
+  if ((pp.absolute != bp.absolute) ||
+      ((bp.n > 0) && (bp.len[0] == 2) && (strncmp(bp.start[0], "..", 2) == 0))) {
+    char *cwd;
+    err = svlib_dpi_imported_getcwd(&cwd);
+    if (!err) err = strBufAppend(&absPath, cwd, strlen(cwd));
+    if (!err) err = strBufAppend(&absBase, cwd, strlen(cwd));
+    if (!err) err = strBufAppend(&absPath, "/", 1);
+    if (!err) err = strBufAppend(&absBase, "/", 1);
+    if (!err && !pp.absolute) err = strBufAppend(&absPath, path, strlen(path));
+    if (!err && !bp.absolute) err = strBufAppend(&absBase, base, strlen(base));
+    pathSpansFree(&pp);
+    pathSpansFree(&bp);
+    if (!err) err = pathSpansOf(pp.absolute ? path : absPath.buf, &pp);
+    if (!err && ((err = pathSpansOf(bp.absolute ? base : absBase.buf, &bp)))) pathSpansFree(&pp);
+    if (err) {
+      free(absPath.buf);
+      free(absBase.buf);
+      return err;
+    }
+  }
+
+  for (common = 0; (common < pp.n) && (common < bp.n); common++) {
+    if ((pp.len[common] != bp.len[common]) ||
+        (strncmp(pp.start[common], bp.start[common], pp.len[common]) != 0)) break;
+  }
+  strBufClear(&pathResult);
+  for (i = common; !err && (i < bp.n); i++) {
+    err = strBufAppend(&pathResult, (pathResult.len ? "/.." : ".."), (pathResult.len ? 3 : 2));
+  }
+  for (i = common; !err && (i < pp.n); i++) {
+    if (pathResult.len) err = strBufAppend(&pathResult, "/", 1);
+    if (!err) err = strBufAppend(&pathResult, pp.start[i], pp.len[i]);
+  }
+  if (!err && (pathResult.len == 0)) err = strBufAppend(&pathResult, ".", 1);
+  pathSpansFree(&pp);
+  pathSpansFree(&bp);
+  free(absPath.buf);
+  free(absBase.buf);
+  if (!err) *result = pathResult.buf;
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_pathRealpath(
+ *                            input  string path,
+ *                            output string result);
+ *----------------------------------------------------------------
+ * Absolute path with all symbolic links, "." and ".." resolved,
+ * as realpath(3). The path must exist. Returns 0 or an errno value.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_pathRealpath(const char *path, const char **result) {
+  char   *resolved;
+  int32_t err;
+  *result  = "";
+  resolved = realpath(path, NULL);
+  if (resolved == NULL) return errno;
+  strBufClear(&pathResult);
+  err = strBufAppend(&pathResult, resolved, strlen(resolved));
+  free(resolved);
+  if (!err) *result = pathResult.buf;
+  return err;
+}
+
 /*----------------------------------------------------------------
  *   import "DPI-C" function int svlib_dpi_imported_fileStat(
  *                            input  longint epochSeconds,
@@ -364,6 +935,43 @@ extern int32_t svlib_dpi_imported_localTime(int64_t epochSeconds, int *timeItems
   return 0;
 }
 
+/*
+ * strftime of epochSeconds (as local time) into a strBuf, growing it
+ * as needed. Returns 0, ENOMEM or ERANGE if the result is too long.
+ */
+static int32_t strftimeBuf(int64_t epochSeconds, const char *format, strBuf_p out) {
+  time_t    t = epochSeconds;  /* to keep C library time functions happy */
+  struct tm timeParts;         /* broken-down time */
+  size_t    n;
+  strBufClear(out);
+  if (*format == 0) return 0;
+  (void) localtime_r(&t, &timeParts);
+  while (1) {
+    if (out->size > 1) {
+      n = strftime(out->buf, out->size, format, &timeParts);
+      if (n != 0) {
+        out->len = n;
+        return 0;
+      }
+      if (out->size >= SVLIB_STRING_BUFFER_LONGEST_PATHNAME) {
+        strBufClear(out);
+        return ERANGE;
+      }
+    }
+    if (strBufReserve(out, out->size ? out->size : SVLIB_STRING_BUFFER_START_SIZE)) return ENOMEM;
+  }
+}
+
+/*
+ * The most recent result of timeFormat in each thread. Timestamps are
+ * usually formatted many times in the same second with the same format,
+ * so this saves most calls to localtime_r and strftime.
+ */
+static SVLIB_THREAD_LOCAL int      timeFormatValid  = 0;
+static SVLIB_THREAD_LOCAL int64_t  timeFormatSecond = 0;
+static SVLIB_THREAD_LOCAL strBuf_s timeFormatFormat = {NULL, 0, 0};
+static SVLIB_THREAD_LOCAL strBuf_s timeFormatResult = {NULL, 0, 0};
+
 /*----------------------------------------------------------------
  * import "DPI-C" function int svlib_dpi_imported_timeFormat(
  *                                       input  longint epochSeconds,
@@ -372,34 +980,30 @@ extern int32_t svlib_dpi_imported_localTime(int64_t epochSeconds, int *timeItems
  *----------------------------------------------------------------
  */
 extern int32_t svlib_dpi_imported_timeFormat(int64_t epochSeconds, const char *format, const char **formatted) {
-
-  size_t bSize = SVLIB_STRING_BUFFER_START_SIZE;
-  char * buf;
-  time_t t = epochSeconds;  /* to keep C library time functions happy */
-
-  struct tm timeParts;        /* broken-down time */
-
-  /* Make the result an empty string iff user's fmt is an empty string */
-  if (strlen(format)==0) {
+  int32_t err;
+  if (timeFormatValid && (epochSeconds == timeFormatSecond) &&
+      (strcmp(format, timeFormatFormat.buf) == 0)) {
+    *formatted = (timeFormatResult.buf == NULL) ? "" : timeFormatResult.buf;
+    return 0;
+  }
+  timeFormatValid = 0;
+  err = strftimeBuf(epochSeconds, format, &timeFormatResult);
+  if (err == ERANGE) {
+    *formatted = "timeFormat result exceeds maximum buffer length "
+                 STRINGIFY(SVLIB_STRING_BUFFER_LONGEST_PATHNAME);
+    return err;
+  }
+  if (err) {
     *formatted = "";
+    return err;
   }
-
-  (void) localtime_r(&t, &timeParts);
-
-  while (1) {
-    buf   = getLibStringBuffer(bSize);
-    bSize = getLibStringBufferSize();
-    if (0 != strftime(buf, bSize, format, &timeParts)) {
-      *formatted = buf;
-      return 0;
-    } else if (bSize >= SVLIB_STRING_BUFFER_LONGEST_PATHNAME) {
-      *formatted = "timeFormat result exceeds maximum buffer length "
-                  STRINGIFY(SVLIB_STRING_BUFFER_LONGEST_PATHNAME);
-      return ERANGE;
-    } else {
-      bSize *= 2;
-    }
+  strBufClear(&timeFormatFormat);
+  if (strBufAppend(&timeFormatFormat, format, strlen(format)) == 0) {
+    timeFormatSecond = epochSeconds;
+    timeFormatValid  = 1;
   }
+  *formatted = (timeFormatResult.buf == NULL) ? "" : timeFormatResult.buf;
+  return 0;
 }
 extern int32_t svlib_dpi_imported_timeFormatST(int64_t epochSeconds, const char **timeST) {
 
@@ -481,16 +1085,59 @@ extern int32_t svlib_dpi_imported_globStart(const char *pattern, void **h, uint3
 
 typedef struct stat s_stat, *p_stat;
 
+/* Nanoseconds part of a stat timestamp: st_mtim etc. in POSIX.1-2008,
+ * but glibc names them st_mtimensec etc. under _XOPEN_SOURCE 600, and
+ * macOS has st_mtimespec.
+ */
+#if defined(__APPLE__)
+#define statNsec(s, t) ((s)->st_##t##timespec.tv_nsec)
+#elif defined(__USE_XOPEN2K8) || (defined(_POSIX_C_SOURCE) && (_POSIX_C_SOURCE >= 200809L))
+#define statNsec(s, t) ((s)->st_##t##tim.tv_nsec)
+#elif defined(__GLIBC__)
+#define statNsec(s, t) ((s)->st_##t##timensec)
+#else
+#define statNsec(s, t) (0)
+#endif
+
+static void statToArray(const s_stat *s, int64_t *stats) {
+  stats[statMTIME]   = s->st_mtime;
+  stats[statATIME]   = s->st_atime;
+  stats[statCTIME]   = s->st_ctime;
+  stats[statSIZE]    = s->st_size;
+  stats[statUID]     = s->st_uid;
+  stats[statGID]     = s->st_gid;
+  stats[statMODE]    = s->st_mode;
+  stats[statMTIMENS] = statNsec(s, m);
+  stats[statATIMENS] = statNsec(s, a);
+  stats[statCTIMENS] = statNsec(s, c);
+  stats[statINODE]   = s->st_ino;
+  stats[statDEVICE]  = s->st_dev;
+}
+
+/* Copy stat data to elements [entry*statARRAYSIZE +: statARRAYSIZE]
+ * of an SV array of longint.
+ */
+static void statToOpenArray(const s_stat *s, const svOpenArrayHandle stats, int32_t entry) {
+  int64_t st[statARRAYSIZE];
+  int32_t k, lo = svLow(stats, 1) + entry*statARRAYSIZE;
+  statToArray(s, st);
+  for (k=0; k<statARRAYSIZE; k++)
+    *(int64_t*)svGetArrElemPtr1(stats, lo + k) = st[k];
+}
+
 /*----------------------------------------------------------------
  *   import "DPI-C" function int svlib_dpi_imported_fileStat(
  *                            input  string  path,
  *                            input  int     asLink,
- *                            output longint stats[statARRAYSIZE]);
+ *                            output longint stats[]);
+ *----------------------------------------------------------------
+ * stats must have at least statARRAYSIZE elements.
  *----------------------------------------------------------------
  */
-extern int32_t svlib_dpi_imported_fileStat(const char *path, int asLink, int64_t *stats) {
+extern int32_t svlib_dpi_imported_fileStat(const char *path, int asLink, const svOpenArrayHandle stats) {
   s_stat s;
   uint32_t e;
+  if (svSize(stats, 1) < statARRAYSIZE) return EINVAL;
   if (asLink) {
     /* if *path is a symlink, don't follow the link but stat it */
     e = lstat(path, &s);
@@ -501,48 +1148,610 @@ extern int32_t svlib_dpi_imported_fileStat(const char *path, int asLink, int64_t
   if (e) {
     return errno;
   } else {
-    stats[statMTIME] = s.st_mtime;
-    stats[statATIME] = s.st_atime;
-    stats[statCTIME] = s.st_ctime;
-    stats[statSIZE]  = s.st_size;
-    stats[statUID]   = s.st_uid;
-    stats[statGID]   = s.st_gid;
-    stats[statMODE]  = s.st_mode;
+    statToOpenArray(&s, stats, 0);
     return 0;
   }
 }
 
 /*----------------------------------------------------------------
- *   import "DPI-C" function void svlib_dpi_imported_hiResTime(
- *                                   input  int     getResolution,
- *                                   output longint seconds,
- *                                   output longint nanoseconds);
+ *   import "DPI-C" function int svlib_dpi_imported_fileStatMany(
+ *                            input  string  paths[],
+ *                            input  int     asLink,
+ *                            output int     errs[],
+ *                            output longint stats[]);
+ *----------------------------------------------------------------
+ * stat (or lstat) every path in one call. errs[i] is 0 or the errno
+ * for paths[i], and if it is 0 the stat data for paths[i] is
+ * stats[i*statARRAYSIZE +: statARRAYSIZE]. Returns EINVAL if errs or
+ * stats is too small, otherwise 0.
  *----------------------------------------------------------------
  */
-extern void svlib_dpi_imported_hiResTime(
-    int getResolution,
-    int64_t *seconds,
-    int64_t *nanoseconds
+extern int32_t svlib_dpi_imported_fileStatMany(
+    const svOpenArrayHandle paths,
+    int32_t                 asLink,
+    const svOpenArrayHandle errs,
+    const svOpenArrayHandle stats
   ) {
-  struct timespec t;
-  if (getResolution) {
-    (void) clock_getres(CLOCK_REALTIME, &t);
-  } else {
-    (void) clock_gettime(CLOCK_REALTIME, &t);
+  s_stat      s;
+  int32_t     i, n, loP, loE;
+  const char *path;
+  n = svSize(paths, 1);
+  if ((svSize(errs, 1) < n) || (svSize(stats, 1) / statARRAYSIZE < n)) return EINVAL;
+  loP = svLow(paths, 1);
+  loE = svLow(errs, 1);
+  for (i=0; i<n; i++) {
+    path = *(const char**)svGetArrElemPtr1(paths, loP+i);
+    if ((asLink ? lstat(path, &s) : stat(path, &s)) == 0) {
+      *(int32_t*)svGetArrElemPtr1(errs, loE+i) = 0;
+      statToOpenArray(&s, stats, i);
+    } else {
+      *(int32_t*)svGetArrElemPtr1(errs, loE+i) = errno;
+    }
   }
-  *nanoseconds = t.tv_nsec;
-  *seconds     = t.tv_sec;
+  return 0;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Recursive directory walker, for DirWalker. Directories are read
+ * depth first with one open DIR per level, so memory use depends on
+ * the depth of the tree and not on the number of entries in it.
+ * Every entry is stat'ed as it is read and those that pass the
+ * filters are returned, with their stat data, in batches.
+ */
+typedef struct dirWalkLevel {
+  DIR    *dir;
+  size_t  pathLen;  /* length of this directory's path, with its '/' */
+  dev_t   dev;
+  ino_t   ino;
+} dirWalkLevel_s, *dirWalkLevel_p;
+
+typedef struct dirWalker {
+  struct dirWalker *sanity_check;
+  dirWalkLevel_p    levels;
+  int32_t           nLevels;
+  int32_t           maxLevels;
+  int32_t           maxDepth;     /* <0 for no limit */
+  int32_t           typeMask;     /* bit (st_mode>>12) set for wanted types, 0 for all */
+  int32_t           followLinks;
+  int32_t           matchKind;    /* 0: everything, 1: glob, 2: regex */
+  char             *glob;
+  regex_t           re;
+  int32_t           nSkipped;     /* entries or directories that could not be read */
+  strBuf_s          path;         /* path of the current entry */
+  strBuf_s          batch;
+} dirWalker_s, *dirWalker_p;
+
+static void dirWalkerFree(dirWalker_p w) {
+  if (w == NULL) return;
+  while (w->nLevels > 0) closedir(w->levels[--w->nLevels].dir);
+  free(w->levels);
+  free(w->glob);
+  if (w->matchKind == 2) regfree(&w->re);
+  free(w->path.buf);
+  free(w->batch.buf);
+  w->sanity_check = NULL;
+  free(w);
+}
+
+/* Open the directory whose path is in w->path and make it the
+ * innermost level. Returns errno on failure.
+ */
+static int32_t dirWalkerPush(dirWalker_p w, const s_stat *s) {
+  dirWalkLevel_p lv;
+  DIR           *d;
+  if (w->nLevels == w->maxLevels) {
+    int32_t        newMax = w->maxLevels ? 2*w->maxLevels : 16;
+    dirWalkLevel_p p = realloc(w->levels, newMax * sizeof(dirWalkLevel_s));
+    if (p == NULL) return ENOMEM;
+    w->levels    = p;
+    w->maxLevels = newMax;
+  }
+  d = opendir(w->path.len ? w->path.buf : ".");
+  if (d == NULL) return errno;
+  if (w->path.len && (w->path.buf[w->path.len-1] != '/')) {
+    if (strBufAppend(&w->path, "/", 1)) {
+      closedir(d);
+      return ENOMEM;
+    }
+  }
+  lv = &w->levels[w->nLevels++];
+  lv->dir     = d;
+  lv->pathLen = w->path.len;
+  lv->dev     = s->st_dev;
+  lv->ino     = s->st_ino;
+  return 0;
 }
 
 /*----------------------------------------------------------------
- *  import "DPI-C" function string svlib_dpi_imported_regexErrorString(input int err, input string re);
+ * import "DPI-C" function int svlib_dpi_imported_dirWalkOpen(
+ *                            input  string  root,
+ *                            input  string  pattern,
+ *                            input  int     isRegex,
+ *                            input  int     maxDepth,
+ *                            input  int     typeMask,
+ *                            input  int     followLinks,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ * Entries directly in root have depth 1; a negative maxDepth means
+ * no limit. The pattern (a glob for fnmatch, or an extended RE) is
+ * matched against each entry's name, not its whole path; an empty
+ * pattern matches everything. Symbolic links to directories are
+ * followed only if followLinks is set, and never into a directory
+ * that is already being read.
  *----------------------------------------------------------------
  */
-extern const char* svlib_dpi_imported_regexErrorString(int32_t err, const char* re) {
-  uint32_t actSize, bSize;
-  regex_t  compiled;
-  char* buf;
-  err = regcomp(&compiled, re, REG_EXTENDED);
+extern int32_t svlib_dpi_imported_dirWalkOpen(
+    const char *root,
+    const char *pattern,
+    int32_t     isRegex,
+    int32_t     maxDepth,
+    int32_t     typeMask,
+    int32_t     followLinks,
+    void      **hnd
+  ) {
+  dirWalker_p w;
+  s_stat      s;
+  int32_t     err;
+
+  *hnd = NULL;
+  if (stat(*root ? root : ".", &s)) return errno;
+  if (!S_ISDIR(s.st_mode)) return ENOTDIR;
+  w = calloc(1, sizeof(dirWalker_s));
+  if (w == NULL) return ENOMEM;
+  w->sanity_check = w;
+  w->maxDepth     = maxDepth;
+  w->typeMask     = typeMask;
+  w->followLinks  = followLinks;
+  if (*pattern) {
+    if (isRegex) {
+      if (regcomp(&w->re, pattern, REG_EXTENDED | REG_NOSUB)) {
+        dirWalkerFree(w);
+        return EINVAL;
+      }
+      w->matchKind = 2;
+    } else {
+      w->glob = strdup(pattern);
+      if (w->glob == NULL) {
+        dirWalkerFree(w);
+        return ENOMEM;
+      }
+      w->matchKind = 1;
+    }
+  }
+  err = strBufAppend(&w->path, root, strlen(root));
+  if (!err) err = dirWalkerPush(w, &s);
+  if (err) {
+    dirWalkerFree(w);
+    return err;
+  }
+  *hnd = w;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_dirWalkNext(
+ *                            inout  chandle hnd,
+ *                            output string  paths[],
+ *                            output int     depths[],
+ *                            output longint stats[],
+ *                            output int     nSkipped,
+ *                            output int     n);
+ *----------------------------------------------------------------
+ * Fetch the next batch of up to paths.size() matching entries.
+ * Entry i's stat data is stats[i*statARRAYSIZE +: statARRAYSIZE].
+ * The path strings remain valid until the next call. When the walk
+ * is complete, n=0 and the handle is released and nulled. If memory
+ * runs out, returns ENOMEM with n set to the number of entries
+ * already fetched, which are valid; the walk cannot be continued.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_dirWalkNext(
+    void                  **hnd,
+    const svOpenArrayHandle paths,
+    const svOpenArrayHandle depths,
+    const svOpenArrayHandle stats,
+    int32_t                *nSkipped,
+    int32_t                *n
+  ) {
+  dirWalker_p    w = (dirWalker_p)(*hnd);
+  dirWalkLevel_p top;
+  struct dirent *de;
+  s_stat         s;
+  int32_t        i, size, depth, isDir, err, result = 0;
+  size_t         bpos;
+
+  *n = 0;
+  if (w == NULL) return 0;
+  if (w->sanity_check != w) return EINVAL;
+
+  size = svSize(paths, 1);
+  if (svSize(depths, 1) < size) size = svSize(depths, 1);
+  if (svSize(stats, 1) / statARRAYSIZE < size) size = svSize(stats, 1) / statARRAYSIZE;
+
+  strBufClear(&w->batch);
+  i = 0;
+  while ((i < size) && (w->nLevels > 0)) {
+    top = &w->levels[w->nLevels-1];
+    de = readdir(top->dir);
+    if (de == NULL) {
+      closedir(top->dir);
+      w->nLevels--;
+      continue;
+    }
+    if ((de->d_name[0] == '.') &&
+        ((de->d_name[1] == 0) || ((de->d_name[1] == '.') && (de->d_name[2] == 0)))) continue;
+
+    w->path.len = top->pathLen;
+    if (strBufAppend(&w->path, de->d_name, strlen(de->d_name))) {
+      result = ENOMEM;
+      break;
+    }
+    if (lstat(w->path.buf, &s)) {
+      w->nSkipped++;
+      continue;
+    }
+    if (w->followLinks && S_ISLNK(s.st_mode)) {
+      s_stat target;
+      if (stat(w->path.buf, &target) == 0) s = target;  /* else a dangling link */
+    }
+    depth = w->nLevels;
+    isDir = S_ISDIR(s.st_mode);
+
+    if ( ((w->typeMask == 0) || (w->typeMask & (1 << ((s.st_mode & S_IFMT) >> 12))))
+      && ( (w->matchKind == 0)
+        || ((w->matchKind == 1) && (fnmatch(w->glob, de->d_name, 0) == 0))
+        || ((w->matchKind == 2) && (regexec(&w->re, de->d_name, 0, NULL, 0) == 0)) ) ) {
+      if (strBufAppend(&w->batch, w->path.buf, w->path.len)) {
+        result = ENOMEM;
+        break;
+      }
+      w->batch.len++;  /* keep the terminating null */
+      statToOpenArray(&s, stats, i);
+      *(int32_t*)svGetArrElemPtr1(depths, svLow(depths, 1) + i) = depth;
+      i++;
+    }
+
+    if (isDir && ((w->maxDepth < 0) || (depth < w->maxDepth))) {
+      int32_t j, loop = 0;
+      for (j=0; j<w->nLevels; j++)
+        if ((w->levels[j].dev == s.st_dev) && (w->levels[j].ino == s.st_ino)) loop = 1;
+      if (!loop) {
+        err = dirWalkerPush(w, &s);
+        if (err == ENOMEM) {
+          result = err;
+          break;
+        }
+        if (err) w->nSkipped++;
+      }
+    }
+  }
+  *n = i;
+  *nSkipped = w->nSkipped;
+
+  /* The batch buffer is now complete, so its path pointers are stable */
+  bpos = 0;
+  for (i=0; i<*n; i++) {
+    *(const char**)svGetArrElemPtr1(paths, svLow(paths, 1) + i) = w->batch.buf + bpos;
+    bpos += strlen(w->batch.buf + bpos) + 1;
+  }
+  if ((*n == 0) && !result) {
+    dirWalkerFree(w);
+    *hnd = NULL;
+  }
+  return result;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_dirWalkClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ * Release a walker before it has finished.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_dirWalkClose(void **hnd) {
+  dirWalker_p w = (dirWalker_p)(*hnd);
+  if ((w != NULL) && (w->sanity_check == w)) dirWalkerFree(w);
+  *hnd = NULL;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function void svlib_dpi_imported_hiResTime(
+ *                                   input  int     getResolution,
+ *                                   output longint seconds,
+ *                                   output longint nanoseconds);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_hiResTime(
+    int getResolution,
+    int64_t *seconds,
+    int64_t *nanoseconds
+  ) {
+  struct timespec t;
+  if (getResolution) {
+    (void) clock_getres(CLOCK_REALTIME, &t);
+  } else {
+    (void) clock_gettime(CLOCK_REALTIME, &t);
+  }
+  *nanoseconds = t.tv_nsec;
+  *seconds     = t.tv_sec;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Clocks and profiling regions, for sys_clockNsTime and ProfRegion.
+ * Each region accumulates the count, total, minimum and maximum of its
+ * samples, and a histogram of them with one bucket per power of two
+ * nanoseconds. start/stop pairs nest, each stop matching the most
+ * recent unmatched start of the same region.
+ */
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC CLOCK_REALTIME
+#endif
+#ifndef CLOCK_THREAD_CPUTIME_ID
+#define CLOCK_THREAD_CPUTIME_ID CLOCK_PROCESS_CPUTIME_ID
+#endif
+#ifndef CLOCK_PROCESS_CPUTIME_ID
+#define CLOCK_PROCESS_CPUTIME_ID CLOCK_REALTIME
+#endif
+
+#define SVLIB_PROF_BUCKETS (64)
+
+static clockid_t clockIdOf(int32_t kind) {
+  switch (kind) {
+    case clockMONOTONIC:  return CLOCK_MONOTONIC;
+    case clockTHREADCPU:  return CLOCK_THREAD_CPUTIME_ID;
+    case clockPROCESSCPU: return CLOCK_PROCESS_CPUTIME_ID;
+    default:              return CLOCK_REALTIME;
+  }
+}
+
+static int64_t clockNow(int32_t kind) {
+  struct timespec t;
+  (void) clock_gettime(clockIdOf(kind), &t);
+  return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+typedef struct profRegion {
+  char    *name;
+  int32_t  clock;
+  int64_t  stat[profARRAYSIZE];
+  int64_t  hist[SVLIB_PROF_BUCKETS];
+  int64_t *starts;
+  int32_t  maxStarts;
+} profRegion_s, *profRegion_p;
+
+static profRegion_p profRegions    = NULL;
+static int32_t      profNRegions   = 0;
+static int32_t      profMaxRegions = 0;
+static pthread_mutex_t profLock     = PTHREAD_MUTEX_INITIALIZER;
+
+static profRegion_p profRegionOf(int32_t id) {
+  return ((id >= 0) && (id < profNRegions)) ? &profRegions[id] : NULL;
+}
+
+static void profRecord(profRegion_p r, int64_t ns) {
+  int32_t b = 0;
+  if (ns < 0) ns = 0;
+  if ((r->stat[profCOUNT] == 0) || (ns < r->stat[profMIN])) r->stat[profMIN] = ns;
+  if (ns > r->stat[profMAX]) r->stat[profMAX] = ns;
+  r->stat[profCOUNT]++;
+  r->stat[profTOTAL] += ns;
+  while ((ns >>= 1) != 0) b++;
+  r->hist[b]++;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function longint svlib_dpi_imported_clockTime(
+ *                                   input  int     kind,
+ *                                   input  int     getResolution);
+ *----------------------------------------------------------------
+ * Time (or resolution) of a CLOCK_KIND_ENUM clock, in nanoseconds.
+ *----------------------------------------------------------------
+ */
+extern int64_t svlib_dpi_imported_clockTime(int32_t kind, int32_t getResolution) {
+  struct timespec t;
+  if (!getResolution) return clockNow(kind);
+  (void) clock_getres(clockIdOf(kind), &t);
+  return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profCreate(
+ *                                   input  string  name,
+ *                                   input  int     clock,
+ *                                   output int     id);
+ *----------------------------------------------------------------
+ * Make a new region. Names are not checked for uniqueness; that
+ * is left to SV.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profCreate(const char *name, int32_t clock, int32_t *id) {
+  profRegion_p r;
+  int32_t      err = 0;
+  *id = -1;
+  pthread_mutex_lock(&profLock);
+  if (profNRegions == profMaxRegions) {
+    int32_t      newMax = profMaxRegions ? 2*profMaxRegions : 16;
+    profRegion_p p = realloc(profRegions, newMax * sizeof(profRegion_s));
+    if (p == NULL) {
+      err = ENOMEM;
+    } else {
+      profRegions    = p;
+      profMaxRegions = newMax;
+    }
+  }
+  if (!err) {
+    r = &profRegions[profNRegions];
+    memset(r, 0, sizeof(profRegion_s));
+    r->name  = strdup(name);
+    r->clock = clock;
+    if (r->name == NULL) err = ENOMEM; else *id = profNRegions++;
+  }
+  pthread_mutex_unlock(&profLock);
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profStart(
+ *                                   input  int     id);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profStart(int32_t id) {
+  profRegion_p r;
+  int32_t      err = 0;
+  pthread_mutex_lock(&profLock);
+  r = profRegionOf(id);
+  if (r == NULL) {
+    err = EINVAL;
+  } else if (r->stat[profOPEN] == r->maxStarts) {
+    int32_t  newMax = r->maxStarts ? 2*r->maxStarts : 4;
+    int64_t *p = realloc(r->starts, newMax * sizeof(int64_t));
+    if (p == NULL) {
+      err = ENOMEM;
+    } else {
+      r->starts    = p;
+      r->maxStarts = newMax;
+    }
+  }
+  if (!err) r->starts[r->stat[profOPEN]++] = clockNow(r->clock);
+  pthread_mutex_unlock(&profLock);
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profStop(
+ *                                   input  int     id,
+ *                                   output longint ns);
+ *----------------------------------------------------------------
+ * Record the time since the matching start, and return it in ns.
+ * Returns EINVAL if there is no unmatched start.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profStop(int32_t id, int64_t *ns) {
+  profRegion_p r;
+  int32_t      err = EINVAL;
+  *ns = 0;
+  pthread_mutex_lock(&profLock);
+  r = profRegionOf(id);
+  if ((r != NULL) && (r->stat[profOPEN] > 0)) {
+    *ns = clockNow(r->clock) - r->starts[--r->stat[profOPEN]];
+    profRecord(r, *ns);
+    err = 0;
+  }
+  pthread_mutex_unlock(&profLock);
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profRecord(
+ *                                   input  int     id,
+ *                                   input  longint ns);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profRecord(int32_t id, int64_t ns) {
+  profRegion_p r;
+  pthread_mutex_lock(&profLock);
+  r = profRegionOf(id);
+  if (r != NULL) profRecord(r, ns);
+  pthread_mutex_unlock(&profLock);
+  return (r == NULL) ? EINVAL : 0;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profStats(
+ *                                   input  int     id,
+ *                                   output longint stats[profARRAYSIZE],
+ *                                   output longint hist[64]);
+ *----------------------------------------------------------------
+ * hist[k] counts samples of at least 2**k ns and less than
+ * 2**(k+1) ns, except that hist[0] also counts samples of 0 ns.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profStats(int32_t id, int64_t *stats, int64_t *hist) {
+  profRegion_p r;
+  pthread_mutex_lock(&profLock);
+  r = profRegionOf(id);
+  if (r != NULL) {
+    memcpy(stats, r->stat, sizeof(r->stat));
+    memcpy(hist,  r->hist, sizeof(r->hist));
+  }
+  pthread_mutex_unlock(&profLock);
+  return (r == NULL) ? EINVAL : 0;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function void svlib_dpi_imported_profReset(
+ *                                   input  int     id);
+ *----------------------------------------------------------------
+ * Clear the statistics of one region, or of all regions if id<0.
+ * Unmatched starts are kept.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_profReset(int32_t id) {
+  int32_t i, open;
+  pthread_mutex_lock(&profLock);
+  for (i=0; i<profNRegions; i++) {
+    if ((id < 0) || (id == i)) {
+      open = profRegions[i].stat[profOPEN];
+      memset(profRegions[i].stat, 0, sizeof(profRegions[i].stat));
+      memset(profRegions[i].hist, 0, sizeof(profRegions[i].hist));
+      profRegions[i].stat[profOPEN] = open;
+    }
+  }
+  pthread_mutex_unlock(&profLock);
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_profDump(
+ *                                   input  string  path,
+ *                                   input  int     append);
+ *----------------------------------------------------------------
+ * Write every region's statistics to a file, one line per region:
+ *   name clock count total min max mean
+ * with times in ns, each followed by a line starting '#' that lists
+ * the non-empty histogram buckets as 2^k:count.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_profDump(const char *path, int32_t append) {
+  static const char * const clockNames[] = {"REALTIME", "MONOTONIC", "THREADCPU", "PROCESSCPU"};
+  FILE   *f;
+  int32_t i, k, err = 0;
+  f = fopen(path, append ? "a" : "w");
+  if (f == NULL) return errno;
+  pthread_mutex_lock(&profLock);
+  fprintf(f, "# svlib profile: %d regions\n", profNRegions);
+  fprintf(f, "# name clock count total_ns min_ns max_ns mean_ns\n");
+  for (i=0; i<profNRegions; i++) {
+    profRegion_p r = &profRegions[i];
+    fprintf(f, "%s %s %lld %lld %lld %lld %lld\n",
+      r->name,
+      ((r->clock >= 0) && (r->clock <= clockPROCESSCPU)) ? clockNames[r->clock] : "?",
+      (long long)r->stat[profCOUNT], (long long)r->stat[profTOTAL],
+      (long long)r->stat[profMIN],   (long long)r->stat[profMAX],
+      (long long)(r->stat[profCOUNT] ? r->stat[profTOTAL] / r->stat[profCOUNT] : 0));
+    fprintf(f, "#   histogram");
+    for (k=0; k<SVLIB_PROF_BUCKETS; k++)
+      if (r->hist[k]) fprintf(f, " 2^%d:%lld", k, (long long)r->hist[k]);
+    fprintf(f, "\n");
+  }
+  pthread_mutex_unlock(&profLock);
+  if (ferror(f)) err = EIO;
+  if (fclose(f) && !err) err = errno;
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *  import "DPI-C" function string svlib_dpi_imported_regexErrorString(input int err, input string re);
+ *----------------------------------------------------------------
+ */
+extern const char* svlib_dpi_imported_regexErrorString(int32_t err, const char* re) {
+  uint32_t actSize, bSize;
+  regex_t  compiled;
+  char* buf;
+  err = regcomp(&compiled, re, REG_EXTENDED);
   if (!err) {
     buf = NULL;
   } else {
@@ -592,14 +1801,270 @@ extern const char* svlib_dpi_imported_regexErrorString(int32_t err, const char*
 */
 }
 
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Cache of compiled regular expressions.
+ * Compiling a regex is far more expensive than running it, so every
+ * compiled RE is kept in a fixed-size table of slots, keyed on the
+ * pattern text and the option bits, and recycled least-recently-used
+ * first. A Regex object remembers a chandle pointing to its slot and
+ * the slot's key (serial number). Each time a slot is recycled it gets
+ * a new key, so a stale handle is detected cheaply and the RE is then
+ * simply looked up (and if necessary recompiled) again.
+ * The slots themselves are never freed, so a chandle held by SV code
+ * always points to valid memory even if the slot has been recycled.
+ * The cache is shared by all threads and guarded by reCacheLock. A slot
+ * is pinned (inUse>0) while a caller is running its RE, and pinned slots
+ * are never recycled; if every slot is pinned, the RE is compiled into a
+ * transient entry that is freed when its caller releases it.
+ */
+#ifndef SVLIB_REGEX_CACHE_SIZE
+#define SVLIB_REGEX_CACHE_SIZE (64)
+#endif
+#define SVLIB_REGEX_HASH_SIZE (2*SVLIB_REGEX_CACHE_SIZE+1)
+
+typedef struct reCacheEntry {
+  regex_t               compiled;
+  char                * re;           /* pattern text, NULL if slot unused */
+  int32_t               options;
+  int32_t               key;          /* serial number of this slot's RE   */
+  uint32_t              hash;
+  int32_t               inUse;        /* callers currently running it      */
+  int32_t               transient;    /* not in the cache, free on release */
+  struct reCacheEntry * hashNext;     /* hash chain, or free list          */
+  struct reCacheEntry * lruPrev;      /* towards most recently used        */
+  struct reCacheEntry * lruNext;      /* towards least recently used       */
+  struct reCacheEntry * sanity_check; /* pointer-to-self for checking      */
+} reCacheEntry_s, *reCacheEntry_p;
+
+static reCacheEntry_s reCache[SVLIB_REGEX_CACHE_SIZE];
+static reCacheEntry_p reCacheHash[SVLIB_REGEX_HASH_SIZE];
+static reCacheEntry_p reCacheMRU       = NULL;
+static reCacheEntry_p reCacheLRU       = NULL;
+static reCacheEntry_p reCacheFree      = NULL;
+static int32_t        reCacheUsed      = 0;   /* slots ever brought into use */
+static int32_t        reCacheEntries   = 0;   /* slots currently holding a RE */
+static int32_t        reCacheLastKey   = 0;
+static int64_t        reCacheHits      = 0;
+static int64_t        reCacheMisses    = 0;
+static int64_t        reCacheEvictions = 0;
+static pthread_mutex_t reCacheLock     = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t reCacheHashOf(const char *re, int32_t options) {
+  /* FNV-1a */
+  uint32_t h = 2166136261u;
+  while (*re) {
+    h ^= (unsigned char)(*re++);
+    h *= 16777619u;
+  }
+  h ^= (uint32_t)options;
+  h *= 16777619u;
+  return h;
+}
+
+static void reCacheUnlinkLRU(reCacheEntry_p e) {
+  if (e->lruPrev) e->lruPrev->lruNext = e->lruNext; else reCacheMRU = e->lruNext;
+  if (e->lruNext) e->lruNext->lruPrev = e->lruPrev; else reCacheLRU = e->lruPrev;
+  e->lruPrev = e->lruNext = NULL;
+}
+
+static void reCachePushMRU(reCacheEntry_p e) {
+  e->lruPrev = NULL;
+  e->lruNext = reCacheMRU;
+  if (reCacheMRU) reCacheMRU->lruPrev = e;
+  reCacheMRU = e;
+  if (reCacheLRU == NULL) reCacheLRU = e;
+}
+
+static void reCacheMakeMRU(reCacheEntry_p e) {
+  if (reCacheMRU == e) return;
+  reCacheUnlinkLRU(e);
+  reCachePushMRU(e);
+}
+
+/*
+ * Discard the least recently used RE that is not in use, returning its
+ * (now empty) slot, or NULL if every slot is in use.
+ */
+static reCacheEntry_p reCacheEvict() {
+  reCacheEntry_p  e = reCacheLRU;
+  reCacheEntry_p *pp;
+  while ((e != NULL) && (e->inUse > 0)) e = e->lruPrev;
+  if (e == NULL) return NULL;
+  reCacheUnlinkLRU(e);
+  for (pp = &reCacheHash[e->hash % SVLIB_REGEX_HASH_SIZE]; *pp != NULL; pp = &((*pp)->hashNext)) {
+    if (*pp == e) {
+      *pp = e->hashNext;
+      break;
+    }
+  }
+  regfree(&(e->compiled));
+  free(e->re);
+  e->re = NULL;
+  e->hashNext = NULL;
+  reCacheEntries--;
+  reCacheEvictions++;
+  return e;
+}
+
+/*
+ * Find the compiled form of a RE, compiling it into the cache if it's
+ * not already there. Returns the regcomp() error code, or ENOMEM.
+ * Must be called with reCacheLock held.
+ */
+static int32_t reCacheLookup(const char *re, int32_t options, reCacheEntry_p *found) {
+  uint32_t       hash = reCacheHashOf(re, options);
+  reCacheEntry_p e;
+  int            cflags;
+  int32_t        err;
+
+  *found = NULL;
+  for (e = reCacheHash[hash % SVLIB_REGEX_HASH_SIZE]; e != NULL; e = e->hashNext) {
+    if ((e->hash == hash) && (e->options == options) && (0 == strcmp(e->re, re))) {
+      reCacheHits++;
+      reCacheMakeMRU(e);
+      *found = e;
+      return 0;
+    }
+  }
+  reCacheMisses++;
+
+  /* Get an empty slot */
+  if (reCacheFree != NULL) {
+    e = reCacheFree;
+    reCacheFree = e->hashNext;
+  } else if (reCacheUsed < SVLIB_REGEX_CACHE_SIZE) {
+    e = &reCache[reCacheUsed++];
+  } else {
+    e = reCacheEvict();
+  }
+  if (e == NULL) {
+    /* Every slot is in use by another thread */
+    e = calloc(1, sizeof(reCacheEntry_s));
+    if (e == NULL) return ENOMEM;
+    e->transient = 1;
+  }
+  e->re = strdup(re);
+  if (e->re == NULL) {
+    if (e->transient) {
+      free(e);
+    } else {
+      e->hashNext = reCacheFree;
+      reCacheFree = e;
+    }
+    return ENOMEM;
+  }
+
+  cflags = REG_EXTENDED;
+  if (options & regexNOCASE) cflags |= REG_ICASE;
+  if (options & regexNOLINE) cflags |= REG_NEWLINE;
+  err = regcomp(&(e->compiled), re, cflags);
+  if (err) {
+    /* Don't cache bad REs; return the slot to the free list */
+    regfree(&(e->compiled));
+    free(e->re);
+    e->re = NULL;
+    if (e->transient) {
+      free(e);
+    } else {
+      e->hashNext = reCacheFree;
+      reCacheFree = e;
+    }
+    return err;
+  }
+
+  e->options      = options;
+  e->hash         = hash;
+  if (e->transient) {
+    e->key = 0;
+    *found = e;
+    return 0;
+  }
+  e->key          = ++reCacheLastKey;
+  e->sanity_check = e;
+  e->hashNext     = reCacheHash[hash % SVLIB_REGEX_HASH_SIZE];
+  reCacheHash[hash % SVLIB_REGEX_HASH_SIZE] = e;
+  reCachePushMRU(e);
+  reCacheEntries++;
+  *found = e;
+  return 0;
+}
+
+/*
+ * Get the compiled RE for a Regex object, using the object's
+ * remembered handle if it's still valid. On success the entry
+ * is pinned, and the caller must reCacheRelease() it when it
+ * has finished running the RE.
+ */
+static int32_t reCacheGet(const char *re, int32_t options, void **hnd, int32_t *key, reCacheEntry_p *found) {
+  reCacheEntry_p e = (reCacheEntry_p)(*hnd);
+  int32_t        err = 0;
+  pthread_mutex_lock(&reCacheLock);
+  if ((e != NULL) && (e->sanity_check == e) && (e->re != NULL) && (e->key == *key)) {
+    reCacheMakeMRU(e);
+    *found = e;
+  } else {
+    err = reCacheLookup(re, options, found);
+    if (err || (*found)->transient) {
+      *hnd = NULL;
+      *key = 0;
+    } else {
+      *hnd = (void*)(*found);
+      *key = (*found)->key;
+    }
+  }
+  if (!err) (*found)->inUse++;
+  pthread_mutex_unlock(&reCacheLock);
+  return err;
+}
+
+static void reCacheRelease(reCacheEntry_p e) {
+  pthread_mutex_lock(&reCacheLock);
+  e->inUse--;
+  pthread_mutex_unlock(&reCacheLock);
+  if (e->transient) {
+    regfree(&(e->compiled));
+    free(e->re);
+    free(e);
+  }
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function void svlib_dpi_imported_regexCacheStats(
+ *                            output longint hits,
+ *                            output longint misses,
+ *                            output longint evictions,
+ *                            output int     entries,
+ *                            output int     capacity);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_regexCacheStats(
+    int64_t *hits,
+    int64_t *misses,
+    int64_t *evictions,
+    int32_t *entries,
+    int32_t *capacity
+  ) {
+  pthread_mutex_lock(&reCacheLock);
+  *hits      = reCacheHits;
+  *misses    = reCacheMisses;
+  *evictions = reCacheEvictions;
+  *entries   = reCacheEntries;
+  *capacity  = SVLIB_REGEX_CACHE_SIZE;
+  pthread_mutex_unlock(&reCacheLock);
+}
+
 /*----------------------------------------------------------------
  *   import "DPI-C" function int svlib_dpi_imported_regexRun(
- *                            input  string re,
- *                            input  string str,
- *                            input  int    options,
- *                            input  int    startPos,
- *                            output int    matchCount,
- *                            output int    matchList[]);
+ *                            input  string  re,
+ *                            input  string  str,
+ *                            input  int     options,
+ *                            input  int     startPos,
+ *                            inout  chandle hnd,
+ *                            inout  int     key,
+ *                            output int     matchCount,
+ *                            output int     matchList[]);
  *----------------------------------------------------------------
 */
 extern uint32_t svlib_dpi_imported_regexRun(
@@ -607,15 +2072,16 @@ extern uint32_t svlib_dpi_imported_regexRun(
     const char *str,
     int32_t     options,
     int32_t     startPos,
+    void      **hnd,
+    int32_t    *key,
     int32_t    *matchCount,
     svOpenArrayHandle matchList
   ) {
   uint32_t result;
-  regex_t    compiled;
-  regmatch_t * matches;
+  reCacheEntry_p compiled;
+  regmatch_t * matches = NULL;
   uint32_t numMatches;
   uint32_t i;
-  uint32_t cflags;
 
   /* initialize result */
   *matchCount = 0;
@@ -648,26 +2114,34 @@ extern uint32_t svlib_dpi_imported_regexRun(
     matches = malloc(numMatches * sizeof(regmatch_t));
   }
 
-  cflags = REG_EXTENDED;
-  if (options & regexNOCASE) cflags |= REG_ICASE;
-  if (options & regexNOLINE) cflags |= REG_NEWLINE;
-  result = regcomp(&compiled, re, cflags);
+  result = reCacheGet(re, options, hnd, key, &compiled);
   if (result) {
-    regfree(&compiled);
+    if (numMatches) free(matches);
     return result;
   }
 
-  *matchCount = compiled.re_nsub+1;
-  result = regexec(&compiled, &(str[startPos]), numMatches, matches, 0);
+  *matchCount = compiled->compiled.re_nsub+1;
+  result = regexec(&(compiled->compiled), &(str[startPos]), numMatches, matches, 0);
+  reCacheRelease(compiled);
   if (result == 0) {
-    /* successful match: copy matches into SV from struct[] */
+    /* successful match: copy matches into SV from struct[], directly
+     * into the array's storage if the simulator gives us access to it */
+    int32_t *ml = (int32_t*)svGetArrayPtr(matchList);
     for (i=0; i<numMatches && i<*matchCount; i++) {
+      int32_t so, eo;
       if (matches[i].rm_so < 0) {
-        *(regoff_t*)(svGetArrElemPtr1(matchList, 2*i  )) = -1;
-        *(regoff_t*)(svGetArrElemPtr1(matchList, 2*i+1)) = -1;
+        so = -1;
+        eo = -1;
       } else {
-        *(regoff_t*)(svGetArrElemPtr1(matchList, 2*i  )) = matches[i].rm_so + startPos;
-        *(regoff_t*)(svGetArrElemPtr1(matchList, 2*i+1)) = matches[i].rm_eo + startPos;
+        so = matches[i].rm_so + startPos;
+        eo = matches[i].rm_eo + startPos;
+      }
+      if (ml != NULL) {
+        ml[2*i  ] = so;
+        ml[2*i+1] = eo;
+      } else {
+        *(int32_t*)(svGetArrElemPtr1(matchList, 2*i  )) = so;
+        *(int32_t*)(svGetArrElemPtr1(matchList, 2*i+1)) = eo;
       }
     }
   } else if (result == REG_NOMATCH) {
@@ -675,12 +2149,3878 @@ extern uint32_t svlib_dpi_imported_regexRun(
     result = 0;
     *matchCount = 0;
   }
-  regfree(&compiled);
   if (numMatches) free(matches);
   return result;
 }
 
 
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_regexGrep(
+ *                            input  string  re,
+ *                            input  int     options,
+ *                            inout  chandle hnd,
+ *                            inout  int     key,
+ *                            input  string  lines[],
+ *                            input  int     withGroups,
+ *                            output int     hits[],
+ *                            output int     nHits,
+ *                            output int     nGroups,
+ *                            output chandle groups);
+ *----------------------------------------------------------------
+ * Run one RE over a whole array of strings in a single call.
+ * The indices of matching strings are written to hits[], which
+ * must be at least as big as lines[]. If withGroups is set, the
+ * full match and every group of each matching string (nGroups
+ * strings per hit, "" for a group that didn't participate) are
+ * made available as a saBuf through the groups handle.
+ *----------------------------------------------------------------
+*/
+static int32_t regexGrepCompiled(
+    reCacheEntry_p compiled,
+    const svOpenArrayHandle lines,
+    int32_t     withGroups,
+    const svOpenArrayHandle hits,
+    int32_t    *nHits,
+    int32_t    *nGroups,
+    void      **groups
+  ) {
+  int32_t        result = 0;
+  regmatch_t   * matches = NULL;
+  saBuf_p        sa = NULL;
+  int32_t      * hitPtr;
+  int            i, g, lo, hi, hitLo;
+
+  lo = svLow(lines, 1);
+  hi = svHigh(lines, 1);
+  if (hi < lo) return 0;
+  if (svSize(hits, 1) < hi-lo+1) return EINVAL;
+  hitLo  = svLow(hits, 1);
+  hitPtr = (int32_t*)svGetArrayPtr(hits);
+
+  if (withGroups) {
+    *nGroups = compiled->compiled.re_nsub+1;
+    matches = malloc((*nGroups) * sizeof(regmatch_t));
+    if (matches == NULL) return ENOMEM;
+    result = strListCreate(&sa);
+    if (result) {
+      free(matches);
+      return result;
+    }
+  }
+
+  for (i=lo; i<=hi; i++) {
+    const char *str = *(const char**)svGetArrElemPtr1(lines, i);
+    if (str == NULL) str = "";
+    if (0 != regexec(&(compiled->compiled), str, *nGroups, matches, 0)) continue;
+    if (hitPtr != NULL) {
+      hitPtr[*nHits] = i-lo;
+    } else {
+      *(int32_t*)svGetArrElemPtr1(hits, hitLo + *nHits) = i-lo;
+    }
+    (*nHits)++;
+    for (g=0; g<*nGroups && !result; g++) {
+      if (matches[g].rm_so < 0) {
+        result = strListAppend(sa, "", 0);
+      } else {
+        result = strListAppend(sa, str + matches[g].rm_so, matches[g].rm_eo - matches[g].rm_so);
+      }
+    }
+    if (result) break;
+  }
+
+  free(matches);
+  if (sa != NULL) {
+    if (!result) result = strListFinish(sa);
+    if (result) {
+      strList_freeFunc(sa);
+      *nHits = 0;
+    } else {
+      *groups = (void*)sa;
+    }
+  }
+  return result;
+}
+
+extern int32_t svlib_dpi_imported_regexGrep(
+    const char *re,
+    int32_t     options,
+    void      **hnd,
+    int32_t    *key,
+    const svOpenArrayHandle lines,
+    int32_t     withGroups,
+    const svOpenArrayHandle hits,
+    int32_t    *nHits,
+    int32_t    *nGroups,
+    void      **groups
+  ) {
+  int32_t        err;
+  reCacheEntry_p compiled;
+
+  *nHits   = 0;
+  *nGroups = 0;
+  *groups  = NULL;
+
+  err = reCacheGet(re, options, hnd, key, &compiled);
+  if (err) return err;
+  err = regexGrepCompiled(compiled, lines, withGroups, hits, nHits, nGroups, groups);
+  reCacheRelease(compiled);
+  return err;
+}
+
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_regexSubst(
+ *                            input  string  re,
+ *                            input  int     options,
+ *                            inout  chandle hnd,
+ *                            inout  int     key,
+ *                            input  string  str,
+ *                            input  string  substStr,
+ *                            input  int     startPos,
+ *                            input  int     global,
+ *                            output string  result,
+ *                            output int     count,
+ *                            output int     matchCount,
+ *                            output int     matchList[]);
+ *----------------------------------------------------------------
+ * Search-and-replace, once or (if global is set) for every match,
+ * building the new string in a single pass. In the replacement
+ * string, $0..$9 are replaced with the corresponding submatches;
+ * $ followed by any other character is replaced with the second
+ * character literally. $ at the very end of the replacement string
+ * acts as a literal $, as if it were doubled. $_ and $& are treated
+ * as synonyms for $0.
+ * Matching never starts beyond the end of the string, but is allowed
+ * to start exactly at the end once, to allow for an empty match there.
+ * After a zero-length match, the next match attempt starts one
+ * character further on (fix for defect #23).
+ * On return, matchCount/matchList describe the most recent match
+ * attempt, with positions expressed in the resulting string, exactly
+ * as if each substitution had been done separately.
+ *----------------------------------------------------------------
+*/
+static SVLIB_THREAD_LOCAL strBuf_s substResult = {NULL, 0, 0};
+
+static int32_t regexSubstCompiled(
+    reCacheEntry_p compiled,
+    const char *str,
+    const char *substStr,
+    int32_t     startPos,
+    int32_t     global,
+    const char**result,
+    int32_t    *count,
+    int32_t    *matchCount,
+    svOpenArrayHandle matchList
+  ) {
+  int32_t        err;
+  regmatch_t     matches[10];
+  int32_t        nMatch, numList, g, rc;
+  size_t         i;
+  int32_t      * ml;
+  size_t         len, substLen, pos, copyFrom, ms, me, outPos;
+
+  nMatch = compiled->compiled.re_nsub+1;
+  if (nMatch > 10) nMatch = 10;
+  numList = svSizeOfArray(matchList) / sizeof(int32_t) / 2;
+  ml = (int32_t*)svGetArrayPtr(matchList);
+
+  len      = strlen(str);
+  substLen = strlen(substStr);
+  strBufClear(&substResult);
+  if (strBufReserve(&substResult, len)) return ENOMEM;
+
+  copyFrom = 0;
+  pos      = (startPos < 0) ? 0 : startPos;
+  while (pos <= len) {
+    rc = regexec(&(compiled->compiled), str+pos, nMatch, matches, 0);
+    if (rc == REG_NOMATCH) {
+      *matchCount = 0;
+      break;
+    } else if (rc) {
+      return rc;
+    }
+    ms = pos + matches[0].rm_so;
+    me = pos + matches[0].rm_eo;
+    /* Everything up to the match is unchanged */
+    if (strBufAppend(&substResult, str+copyFrom, ms-copyFrom)) return ENOMEM;
+    /* Report this match, as positions in the partially-substituted string.
+     * Offsets are taken relative to the start of the whole match so that
+     * no unsigned difference can wrap when earlier replacements shrank
+     * the string.
+     */
+    outPos = substResult.len;
+    *matchCount = compiled->compiled.re_nsub+1;
+    for (g=0; g<numList && g<*matchCount; g++) {
+      int32_t so = -1, eo = -1;
+      if ((g < nMatch) && (matches[g].rm_so >= 0)) {
+        so = outPos + (matches[g].rm_so - matches[0].rm_so);
+        eo = outPos + (matches[g].rm_eo - matches[0].rm_so);
+      }
+      if (ml != NULL) {
+        ml[2*g  ] = so;
+        ml[2*g+1] = eo;
+      } else {
+        *(int32_t*)(svGetArrElemPtr1(matchList, 2*g  )) = so;
+        *(int32_t*)(svGetArrElemPtr1(matchList, 2*g+1)) = eo;
+      }
+    }
+    /* Expand the replacement string */
+    for (i=0; i<substLen; i++) {
+      char c = substStr[i];
+      err = 0;
+      if ((i == substLen-1) || (c != '$')) {
+        err = strBufAppend(&substResult, &c, 1);
+      } else {
+        c = substStr[++i];
+        if ((c >= '0' && c <= '9') || (c == '&') || (c == '_')) {
+          g = (c == '&' || c == '_') ? 0 : (c - '0');
+          if ((g < nMatch) && (matches[g].rm_so >= 0)) {
+            err = strBufAppend(&substResult, str + pos + matches[g].rm_so,
+                                     matches[g].rm_eo - matches[g].rm_so);
+          }
+        } else {
+          err = strBufAppend(&substResult, &c, 1);
+        }
+      }
+      if (err) return err;
+    }
+    (*count)++;
+    copyFrom = me;
+    pos      = (me == ms) ? me+1 : me;
+    if (!global) break;
+  }
+  if (strBufAppend(&substResult, str+copyFrom, len-copyFrom)) return ENOMEM;
+  *result = substResult.buf;
+  return 0;
+}
+
+extern int32_t svlib_dpi_imported_regexSubst(
+    const char *re,
+    int32_t     options,
+    void      **hnd,
+    int32_t    *key,
+    const char *str,
+    const char *substStr,
+    int32_t     startPos,
+    int32_t     global,
+    const char**result,
+    int32_t    *count,
+    int32_t    *matchCount,
+    svOpenArrayHandle matchList
+  ) {
+  int32_t        err;
+  reCacheEntry_p compiled;
+
+  *result     = "";
+  *count      = 0;
+  *matchCount = 0;
+
+  err = reCacheGet(re, options, hnd, key, &compiled);
+  if (err) return err;
+  err = regexSubstCompiled(compiled, str, substStr, startPos, global, result, count, matchCount, matchList);
+  reCacheRelease(compiled);
+  return err;
+}
+
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_regexSplit(
+ *                            input  string  re,
+ *                            input  int     options,
+ *                            inout  chandle hnd,
+ *                            inout  int     key,
+ *                            input  string  str,
+ *                            input  int     limit,
+ *                            output chandle fields);
+ *----------------------------------------------------------------
+ * Perl-style split of str on matches of the RE, in a single pass,
+ * returning the fields through a saBuf. Text captured by groups
+ * in the RE is also returned, after the field that precedes it.
+ * A zero-length match at the start of a field is ignored, and the
+ * match retried one character further on. At most ~limit~ fields
+ * are split off if limit>0. If limit==0, trailing empty fields are
+ * discarded.
+ *----------------------------------------------------------------
+*/
+static int32_t regexSplitCompiled(
+    reCacheEntry_p compiled,
+    const char *str,
+    int32_t     limit,
+    void      **fields
+  ) {
+  int32_t        err;
+  regmatch_t   * matches;
+  saBuf_p        sa;
+  int32_t        nMatch, nFields, g, rc;
+  size_t         len, pos, ms, me;
+
+  nMatch  = compiled->compiled.re_nsub+1;
+  matches = malloc(nMatch * sizeof(regmatch_t));
+  if (matches == NULL) return ENOMEM;
+  err = strListCreate(&sa);
+  if (err) {
+    free(matches);
+    return err;
+  }
+
+  len     = strlen(str);
+  pos     = 0;
+  nFields = 0;
+  while (!err && ((limit <= 0) || (nFields < limit)) && (pos <= len)) {
+    rc = regexec(&(compiled->compiled), str+pos, nMatch, matches, 0);
+    if ((rc == 0) && (matches[0].rm_so == 0) && (matches[0].rm_eo == 0)) {
+      /* Zero-length match at anchor point: ignore it, try one character ahead */
+      if (pos+1 <= len) {
+        pos++;
+        rc = regexec(&(compiled->compiled), str+pos, nMatch, matches, 0);
+        pos--;
+        if (rc == 0) {
+          for (g=0; g<nMatch; g++) {
+            if (matches[g].rm_so >= 0) {
+              matches[g].rm_so++;
+              matches[g].rm_eo++;
+            }
+          }
+        }
+      } else {
+        rc = REG_NOMATCH;
+      }
+    }
+    if (rc == REG_NOMATCH) {
+      /* No match. Grab everything up to end-of-string and finish. */
+      err = strListAppend(sa, str+pos, len-pos);
+      break;
+    } else if (rc) {
+      err = rc;
+      break;
+    }
+    /* We have a match. Grab everything up to the match. */
+    ms = pos + matches[0].rm_so;
+    me = pos + matches[0].rm_eo;
+    err = strListAppend(sa, str+pos, ms-pos);
+    nFields++;
+    /* Any subexpressions to capture? */
+    for (g=1; g<nMatch && !err; g++) {
+      if (matches[g].rm_so < 0) {
+        err = strListAppend(sa, "", 0);
+      } else {
+        err = strListAppend(sa, str + pos + matches[g].rm_so, matches[g].rm_eo - matches[g].rm_so);
+      }
+    }
+    pos = me;
+  }
+
+  if (!err && (limit == 0)) {
+    /* Strip trailing empty fields */
+    while ((strListCount(sa) > 0) && (strListLen(sa, strListCount(sa)-1) == 0)) {
+      strListPop(sa);
+    }
+  }
+  free(matches);
+  if (!err) err = strListFinish(sa);
+  if (err) {
+    strList_freeFunc(sa);
+    return err;
+  }
+  *fields = (void*)sa;
+  return 0;
+}
+
+extern int32_t svlib_dpi_imported_regexSplit(
+    const char *re,
+    int32_t     options,
+    void      **hnd,
+    int32_t    *key,
+    const char *str,
+    int32_t     limit,
+    void      **fields
+  ) {
+  int32_t        err;
+  reCacheEntry_p compiled;
+
+  *fields = NULL;
+
+  err = reCacheGet(re, options, hnd, key, &compiled);
+  if (err) return err;
+  err = regexSplitCompiled(compiled, str, limit, fields);
+  reCacheRelease(compiled);
+  return err;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Scanner for Verilog integer literals, as used by scanVerilogInt.
+ * It follows exactly the rules of svlib's original SV implementation
+ * (a NOCASE regex followed by a digit-by-digit scan), generalised
+ * from 64 bits to any result width:
+ *   [space] [-] [space] [[size]'[s]radix] digits [space]
+ * where radix is one of h x d o b (any case), and digits are hex
+ * digits, x, z and underscores, with at least one that is not an
+ * underscore. The size defaults to 32. A decimal value may instead
+ * be a single x or z, which fills the whole result. Otherwise:
+ *  - a value with more digits than the size allows is truncated to
+ *    the size, but a decimal value is first taken modulo 2**width;
+ *  - if the top bit of the digits is x or z, it is copied up to the size;
+ *  - with 's', the bit at size-1 is copied up to the result width;
+ *  - with '-', the result is negated, and becomes all x if any bit is x/z.
+ * The result is in aval/bval words, least significant first, using
+ * the DPI's 4-state encoding (0: a0b0, 1: a1b0, z: a0b1, x: a1b1).
+ */
+#define vlogIsSpace(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\v' || (c)=='\f' || (c)=='\r')
+
+static void vlogSetBit(uint32_t *a, uint32_t *b, int32_t i, uint32_t av, uint32_t bv) {
+  uint32_t m = 1u << (i & 31);
+  a[i>>5] = av ? (a[i>>5] | m) : (a[i>>5] & ~m);
+  b[i>>5] = bv ? (b[i>>5] | m) : (b[i>>5] & ~m);
+}
+
+static void vlogFill(uint32_t *a, uint32_t *b, int32_t nw, uint32_t av, uint32_t bv) {
+  int32_t w;
+  for (w=0; w<nw; w++) {
+    a[w] = av ? ~0u : 0;
+    b[w] = bv ? ~0u : 0;
+  }
+}
+
+static int verilogIntScan(const char *s, size_t len, int32_t width, uint32_t *a, uint32_t *b) {
+  const char *p = s, *e = s + len, *q, *vs, *ve;
+  int32_t     nw = (width + 31) / 32;
+  uint32_t    topMask = (width % 32) ? ((1u << (width % 32)) - 1) : ~0u;
+  int64_t     nBits = 32, msb, i, lim;
+  int         negate = 0, isSigned = 0, radix = 10, shift = 0;
+  uint32_t    ma = 0, mb = 0;
+
+  while (p < e && vlogIsSpace(*p)) p++;
+  if (p < e && *p == '-') {
+    negate = 1;
+    p++;
+    while (p < e && vlogIsSpace(*p)) p++;
+  }
+
+  /* Optional size and base */
+  for (q = p; q < e && *q >= '0' && *q <= '9'; q++) ;
+  if (q < e && *q == '\'') {
+    const char *r = q + 1;
+    if (r < e && (*r == 's' || *r == 'S')) {
+      isSigned = 1;
+      r++;
+    }
+    if (r >= e) return 0;
+    switch (*r | 0x20) {
+      case 'h': case 'x': radix = 16; shift = 4; break;
+      case 'o':           radix = 8;  shift = 3; break;
+      case 'd':           radix = 10;            break;
+      case 'b':           radix = 2;  shift = 1; break;
+      default:            return 0;
+    }
+    if (q > p) {
+      nBits = 0;
+      for (; p < q; p++) {
+        nBits = 10*nBits + (*p - '0');
+        if (nBits > 0x7FFFFFFF) nBits = 0x7FFFFFFF;
+      }
+    }
+    p = r + 1;
+  }
+
+  /* The digits, less leading and trailing underscores, then only space */
+  for (vs = p; p < e; p++) {
+    if (!(isxdigit((unsigned char)*p) || (*p && strchr("xXzZ_", *p)))) break;
+  }
+  ve = p;
+  while (p < e && vlogIsSpace(*p)) p++;
+  if (p != e) return 0;
+  while (vs < ve && *vs == '_') vs++;
+  while (ve > vs && ve[-1] == '_') ve--;
+  if (vs == ve) return 0;
+
+  vlogFill(a, b, nw, 0, 0);
+  if (radix == 10) {
+    if (ve - vs == 1 && ((*vs | 0x20) == 'x' || (*vs | 0x20) == 'z')) {
+      /* x or z fills everything, and so does negating it */
+      vlogFill(a, b, nw, negate || ((*vs | 0x20) == 'x'), 1);
+      a[nw-1] &= topMask;
+      b[nw-1] &= topMask;
+      return 1;
+    }
+    for (q = vs; q < ve; q++) {
+      uint64_t carry;
+      int32_t  w;
+      if (*q == '_') continue;
+      if (*q < '0' || *q > '9') return 0;
+      carry = (uint64_t)(*q - '0');
+      for (w=0; w<nw; w++) {
+        carry += (uint64_t)a[w] * 10;
+        a[w]   = (uint32_t)carry;
+        carry >>= 32;
+      }
+      a[nw-1] &= topMask;
+    }
+    msb = width - 1;
+  } else {
+    msb = -1;
+    for (q = vs; q < ve; q++) {
+      char     c = (char)tolower((unsigned char)*q);
+      uint32_t da, db, d;
+      int32_t  w;
+      if (*q == '_') continue;
+      msb += shift;
+      if (c == 'x') {
+        da = db = (1u << shift) - 1;
+      } else if (c == 'z') {
+        da = 0;
+        db = (1u << shift) - 1;
+      } else {
+        d = (c <= '9') ? (uint32_t)(c - '0') : (uint32_t)(c - 'a' + 10);
+        if (d >= (uint32_t)radix) return 0;
+        da = d;
+        db = 0;
+      }
+      for (w=nw-1; w>0; w--) {
+        a[w] = (a[w] << shift) | (a[w-1] >> (32 - shift));
+        b[w] = (b[w] << shift) | (b[w-1] >> (32 - shift));
+      }
+      a[0] = (a[0] << shift) | da;
+      b[0] = (b[0] << shift) | db;
+      a[nw-1] &= topMask;
+      b[nw-1] &= topMask;
+    }
+  }
+
+  /* Protect against too many digits */
+  lim = (msb < width) ? msb : width - 1;
+  for (i = nBits; i <= lim; i++) vlogSetBit(a, b, i, 0, 0);
+  /* X/Z fill to the size */
+  if (msb < width && ((b[msb>>5] >> (msb & 31)) & 1)) {
+    ma  = (a[msb>>5] >> (msb & 31)) & 1;
+    mb  = 1;
+    lim = (nBits < width) ? nBits : width;
+    for (i = msb+1; i < lim; i++) vlogSetBit(a, b, i, ma, mb);
+  }
+  /* Sign extension to the full width; a size of 0 has an x sign bit */
+  if (isSigned) {
+    if (nBits == 0) {
+      ma = mb = 1;
+    } else if (nBits <= width) {
+      ma = (a[(nBits-1)>>5] >> ((nBits-1) & 31)) & 1;
+      mb = (b[(nBits-1)>>5] >> ((nBits-1) & 31)) & 1;
+    }
+    for (i = nBits; i < width; i++) vlogSetBit(a, b, i, ma, mb);
+  }
+
+  if (negate) {
+    int32_t  w;
+    uint64_t carry = 1;
+    for (w=0; w<nw; w++) {
+      if (b[w]) {
+        vlogFill(a, b, nw, 1, 1);
+        a[nw-1] &= topMask;
+        b[nw-1] &= topMask;
+        return 1;
+      }
+    }
+    for (w=0; w<nw; w++) {
+      carry += (uint64_t)(uint32_t)~a[w];
+      a[w]   = (uint32_t)carry;
+      carry >>= 32;
+    }
+    a[nw-1] &= topMask;
+  }
+  return 1;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_scanVerilogInt(
+ *                            input  string      s,
+ *                            output logic[63:0] result);
+ *----------------------------------------------------------------
+ * Returns 1 if s is a valid literal, else 0 with result untouched.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_scanVerilogInt(const char *s, svLogicVecVal *result) {
+  uint32_t a[2], b[2];
+  if (!verilogIntScan(s, strlen(s), 64, a, b)) return 0;
+  result[0].aval = a[0];  result[0].bval = b[0];
+  result[1].aval = a[1];  result[1].bval = b[1];
+  return 1;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_scanVerilogIntWide(
+ *                            input  string      s,
+ *                            input  int         width,
+ *                            output logic[31:0] words[]);
+ *----------------------------------------------------------------
+ * As scanVerilogInt, for a result of any width. words[] must have
+ * (width+31)/32 elements, least significant first.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_scanVerilogIntWide(
+    const char             *s,
+    int32_t                 width,
+    const svOpenArrayHandle words
+  ) {
+  int32_t   nw = (width + 31) / 32;
+  int32_t   w, lo;
+  uint32_t *a, *b;
+  int32_t   ok;
+  if ((width <= 0) || (svSize(words, 1) < nw)) return 0;
+  a = malloc(2 * nw * sizeof(uint32_t));
+  if (a == NULL) return 0;
+  b = a + nw;
+  ok = verilogIntScan(s, strlen(s), width, a, b);
+  if (ok) {
+    lo = svLow(words, 1);
+    for (w=0; w<nw; w++) {
+      svLogicVecVal *v = (svLogicVecVal*)svGetArrElemPtr1(words, lo+w);
+      v->aval = a[w];
+      v->bval = b[w];
+    }
+  }
+  free(a);
+  return ok;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_scanVerilogIntBatch(
+ *                            input  string      ss[],
+ *                            output logic[63:0] values[],
+ *                            output byte        ok[]);
+ *----------------------------------------------------------------
+ * Scan every string of ss[] into the corresponding element of
+ * values[], setting ok[] to 1 or 0. A string that cannot be
+ * scanned gives all x. Returns the number that could not be scanned.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_scanVerilogIntBatch(
+    const svOpenArrayHandle ss,
+    const svOpenArrayHandle values,
+    const svOpenArrayHandle ok
+  ) {
+  int32_t i, n, loS, loV, loK, nBad = 0;
+  n   = svSize(ss, 1);
+  if (svSize(values, 1) < n) n = svSize(values, 1);
+  if (svSize(ok, 1) < n)     n = svSize(ok, 1);
+  loS = svLow(ss, 1);
+  loV = svLow(values, 1);
+  loK = svLow(ok, 1);
+  for (i=0; i<n; i++) {
+    const char    *s = *(const char**)svGetArrElemPtr1(ss, loS+i);
+    svLogicVecVal *v = (svLogicVecVal*)svGetArrElemPtr1(values, loV+i);
+    uint32_t       a[2], b[2];
+    int            good = (s != NULL) && verilogIntScan(s, strlen(s), 64, a, b);
+    if (!good) {
+      a[0] = a[1] = b[0] = b[1] = ~0u;
+      nBad++;
+    }
+    v[0].aval = a[0];  v[0].bval = b[0];
+    v[1].aval = a[1];  v[1].bval = b[1];
+    *(int8_t*)svGetArrElemPtr1(ok, loK+i) = good;
+  }
+  return nBad;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Substring search kernels. Short needles are found by scanning for their
+ * first character with memchr, which the C library implements with wide or
+ * vector loads on most platforms, and then checking the rest with memcmp.
+ * Longer needles use Boyer-Moore-Horspool, which skips over most of the
+ * haystack without looking at it.
+ */
+#define SVLIB_FIND_HORSPOOL_MIN (8)
+
+static const char* svlib_memfind(const char *hay, size_t hLen, const char *ndl, size_t nLen) {
+  const char *p, *end;
+  if (nLen == 0)   return hay;
+  if (nLen > hLen) return NULL;
+  if (nLen < SVLIB_FIND_HORSPOOL_MIN) {
+    end = hay + (hLen - nLen);     /* last possible start position */
+    p   = hay;
+    while (p <= end) {
+      p = memchr(p, ndl[0], end - p + 1);
+      if (p == NULL) return NULL;
+      if (0 == memcmp(p+1, ndl+1, nLen-1)) return p;
+      p++;
+    }
+    return NULL;
+  } else {
+    size_t skip[256];
+    size_t i, pos;
+    unsigned char last = (unsigned char)ndl[nLen-1];
+    for (i=0; i<256; i++)    skip[i] = nLen;
+    for (i=0; i<nLen-1; i++) skip[(unsigned char)ndl[i]] = nLen-1-i;
+    pos = 0;
+    while (pos <= hLen - nLen) {
+      unsigned char c = (unsigned char)hay[pos+nLen-1];
+      if ((c == last) && (0 == memcmp(hay+pos, ndl, nLen-1))) return hay+pos;
+      pos += skip[c];
+    }
+    return NULL;
+  }
+}
+
+/* As svlib_memfind, but finds the rightmost occurrence */
+static const char* svlib_memrfind(const char *hay, size_t hLen, const char *ndl, size_t nLen) {
+  const char *p;
+  if (nLen == 0)   return hay + hLen;
+  if (nLen > hLen) return NULL;
+  if (nLen < SVLIB_FIND_HORSPOOL_MIN) {
+    for (p = hay + (hLen - nLen); p >= hay; p--) {
+      if ((*p == ndl[0]) && (0 == memcmp(p+1, ndl+1, nLen-1))) return p;
+    }
+    return NULL;
+  } else {
+    size_t skip[256];
+    size_t i;
+    unsigned char first = (unsigned char)ndl[0];
+    for (i=0; i<256; i++)  skip[i] = nLen;
+    for (i=nLen-1; i>0; i--) skip[(unsigned char)ndl[i]] = i;
+    p = hay + (hLen - nLen);
+    while (1) {
+      unsigned char c = (unsigned char)*p;
+      if ((c == first) && (0 == memcmp(p+1, ndl+1, nLen-1))) return p;
+      if ((size_t)(p - hay) < skip[c]) return NULL;
+      p -= skip[c];
+    }
+  }
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_strFind(
+ *                            input string s,
+ *                            input string substr,
+ *                            input int    ignore,
+ *                            input int    fromEnd);
+ *----------------------------------------------------------------
+ * Implementation of Str::first (fromEnd==0) and Str::last (fromEnd!=0).
+ * Returns the position of the leftmost character of the first (last)
+ * occurrence of substr in s, ignoring the first (last) ~ignore~
+ * characters of s; or -1 if there is no such occurrence.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_strFind(
+    const char *s,
+    const char *substr,
+    int32_t     ignore,
+    int32_t     fromEnd
+  ) {
+  int64_t     len    = strlen(s);
+  int64_t     subLen = strlen(substr);
+  int64_t     limit;
+  const char *found;
+  if (!fromEnd) {
+    if (subLen == 0) {
+      /* empty string is found immediately, if start is within the string */
+      return (ignore <= len) ? ignore : -1;
+    }
+    if (ignore < 0) ignore = 0;
+    if (ignore > len - subLen) return -1;
+    found = svlib_memfind(s + ignore, len - ignore, substr, subLen);
+  } else {
+    limit = len - subLen - ignore;  /* rightmost possible start position */
+    if (subLen == 0) {
+      return (limit >= 0) ? limit : -1;
+    }
+    if (limit > len - subLen) limit = len - subLen;
+    if (limit < 0) return -1;
+    found = svlib_memrfind(s, limit + subLen, substr, subLen);
+  }
+  return (found == NULL) ? -1 : (found - s);
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_strFindAll(
+ *                            input  string s,
+ *                            input  string substr,
+ *                            output int    positions[]);
+ *----------------------------------------------------------------
+ * Find all non-overlapping occurrences of substr in s, scanning
+ * from left to right. Returns the number of occurrences, and
+ * writes the positions of as many as will fit into positions[].
+ * An empty substr is never found.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_strFindAll(
+    const char *s,
+    const char *substr,
+    const svOpenArrayHandle positions
+  ) {
+  size_t      len    = strlen(s);
+  size_t      subLen = strlen(substr);
+  const char *p      = s;
+  const char *found;
+  int32_t     count  = 0;
+  int32_t     size   = svSize(positions, 1);
+  int32_t     lo     = svLow(positions, 1);
+  int32_t   * ptr    = (size > 0) ? (int32_t*)svGetArrayPtr(positions) : NULL;
+  if (subLen == 0) return 0;
+  while ((found = svlib_memfind(p, len - (p - s), substr, subLen)) != NULL) {
+    if (count < size) {
+      if (ptr != NULL) {
+        ptr[count] = found - s;
+      } else {
+        *(int32_t*)svGetArrElemPtr1(positions, lo + count) = found - s;
+      }
+    }
+    count++;
+    p = found + subLen;
+  }
+  return count;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * 256-bit character-class bitmap, one bit per byte value. Membership
+ * test is a shift and mask with no data-dependent branch, so scanning
+ * costs the same however many characters are in the class.
+ * charSetSpace matches Str's isSpace(): \t \n space CR and nbsp (160).
+ */
+typedef struct charSet {
+  uint32_t bits[8];
+} charSet_s, *charSet_p;
+
+#define charSetHas(cs, c) \
+  (((cs)->bits[((unsigned char)(c)) >> 5] >> (((unsigned char)(c)) & 31)) & 1)
+
+static const charSet_s charSetSpace = {{
+  (1u<<'\t') | (1u<<'\n') | (1u<<13),  /* 0..31    */
+  (1u<<(' '-32)),                      /* 32..63   */
+  0, 0, 0,
+  (1u<<(160-160)),                     /* 160..191 */
+  0, 0
+}};
+
+static void charSetFromString(charSet_p cs, const char *chars) {
+  memset(cs, 0, sizeof(charSet_s));
+  for (; *chars; chars++) {
+    cs->bits[((unsigned char)*chars) >> 5] |= 1u << (((unsigned char)*chars) & 31);
+  }
+}
+
+/* Index of the first character of s[from..len-1] that is (isIn!=0) or
+ * is not (isIn==0) in the class, or len if there is none. */
+static size_t charSetScan(const charSet_s *cs, const char *s, size_t from, size_t len, int isIn) {
+  isIn = (isIn != 0);
+  while ((from < len) && (charSetHas(cs, s[from]) != (uint32_t)isIn)) from++;
+  return from;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_strSplit(
+ *                            input  string  s,
+ *                            input  string  splitset,
+ *                            input  int     keepSplitters,
+ *                            output chandle fields);
+ *----------------------------------------------------------------
+ * Implementation of Str::split. If splitset is empty, every character
+ * of s becomes a field. Otherwise s is split at every character that
+ * appears in splitset, optionally keeping each splitter as a field of
+ * its own. If splitset contains any whitespace character, any further
+ * whitespace following a splitter is swallowed along with it.
+ * The fields are retrieved with saBufNextBatch.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_strSplit(
+    const char *s,
+    const char *splitset,
+    int32_t     keepSplitters,
+    void      **fields
+  ) {
+  int32_t     err;
+  saBuf_p     sa;
+  size_t      len    = strlen(s);
+  size_t      anchor = 0;
+  size_t      i;
+  int         splitAtWhitespace = 0;
+  charSet_s   splitters;
+
+  *fields = NULL;
+  err = strListCreate(&sa);
+  if (err) return err;
+
+  if (*splitset == 0) {
+    for (i=0; i<len && !err; i++) {
+      err = strListAppend(sa, s+i, 1);
+    }
+  } else {
+    charSetFromString(&splitters, splitset);
+    for (i=0; i<8; i++) {
+      if (splitters.bits[i] & charSetSpace.bits[i]) splitAtWhitespace = 1;
+    }
+    i = charSetScan(&splitters, s, 0, len, 1);
+    while (i<len && !err) {
+      err = strListAppend(sa, s+anchor, i-anchor);
+      if (!err && keepSplitters) {
+        err = strListAppend(sa, s+i, 1);
+      }
+      if (splitAtWhitespace) {
+        while ((i+1 < len) && charSetHas(&charSetSpace, s[i+1])) i++;
+      }
+      anchor = i+1;
+      i = charSetScan(&splitters, s, anchor, len, 1);
+    }
+    if (!err) err = strListAppend(sa, s+anchor, len-anchor);
+  }
+
+  if (!err) err = strListFinish(sa);
+  if (err) {
+    strList_freeFunc(sa);
+    return err;
+  }
+  *fields = (void*)sa;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_strStrip(
+ *                            input  string s,
+ *                            input  string chars,
+ *                            output string result);
+ *----------------------------------------------------------------
+ * Implementation of Str::strip. Removes from s every character
+ * that appears in chars, copying the surviving runs in bulk.
+ *----------------------------------------------------------------
+ */
+static SVLIB_THREAD_LOCAL strBuf_s stripResult = {NULL, 0, 0};
+
+extern int32_t svlib_dpi_imported_strStrip(
+    const char  *s,
+    const char  *chars,
+    const char **result
+  ) {
+  size_t    len = strlen(s);
+  size_t    keep, skip;
+  charSet_s strip;
+  *result = "";
+  charSetFromString(&strip, chars);
+  strBufClear(&stripResult);
+  if (strBufReserve(&stripResult, len)) return ENOMEM;
+  keep = 0;
+  while (keep < len) {
+    keep = charSetScan(&strip, s, keep, len, 0);
+    skip = charSetScan(&strip, s, keep, len, 1);
+    if (strBufAppend(&stripResult, s+keep, skip-keep)) return ENOMEM;
+    keep = skip;
+  }
+  *result = (stripResult.len == 0) ? "" : stripResult.buf;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_strTrim(
+ *                            input  string s,
+ *                            input  int    trimLeft,
+ *                            input  int    trimRight,
+ *                            output int    first,
+ *                            output int    last);
+ *----------------------------------------------------------------
+ * Implementation of Str::trim. Finds the first and last characters
+ * of s that are to be kept, so that s.substr(first, last) is the
+ * trimmed string. If nothing is kept, first > last.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_strTrim(
+    const char *s,
+    int32_t     trimLeft,
+    int32_t     trimRight,
+    int32_t    *first,
+    int32_t    *last
+  ) {
+  int32_t f = 0;
+  int32_t l = strlen(s) - 1;
+  if (trimLeft) {
+    while ((f <= l) && charSetHas(&charSetSpace, s[f])) f++;
+  }
+  if (trimRight) {
+    while ((f <= l) && charSetHas(&charSetSpace, s[l])) l--;
+  }
+  *first = f;
+  *last  = l;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Line reader over a memory-mapped file, for FileLineReader. The whole
+ * file is mapped read-only; each call to lineReaderNext copies a batch
+ * of lines into a single buffer, null-terminating each one, and points
+ * the SV string array at them. As with saBufNextBatch, the strings
+ * most recently delivered stay valid until the next call.
+ * A gzip-compressed file is recognized by its first two bytes, and is
+ * inflated by a background thread into two alternate chunks of
+ * SVLIB_GZ_CHUNK_SIZE bytes: while lineReaderNext takes lines from
+ * one chunk, the thread fills the other. Offsets of lines in such a
+ * file are offsets in the uncompressed text. Compile with
+ * -DSVLIB_NO_ZLIB to do without zlib, reading such files as they are.
+ */
+#ifndef SVLIB_GZ_CHUNK_SIZE
+#define SVLIB_GZ_CHUNK_SIZE (1<<20)
+#endif
+
+typedef struct gzInflater {
+  pthread_t         thread;
+  pthread_mutex_t   lock;
+  pthread_cond_t    cond;
+  const char      * src;        /* the compressed file's mapping */
+  size_t            srcSize;
+  char            * chunk[2];
+  size_t            chunkLen[2];
+  int               full[2];    /* chunk[i] holds text not yet taken by the reader */
+  int               readIdx;    /* the chunk that the reader takes lines from */
+  int               readHeld;   /* the reader has chunk[readIdx]; seen only by the reader */
+  size_t            readPos;    /* position of the reader in chunk[readIdx] */
+  int               eof;        /* the inflater has filled its last chunk */
+  int               stop;       /* the reader is closing */
+  int32_t           err;
+} gzInflater_s, *gzInflater_p;
+
+typedef struct lineReader {
+  struct lineReader * sanity_check;
+  char              * base;   /* the mapping, or NULL for an empty file */
+  size_t              size;
+  size_t              pos;    /* offset of the next line to deliver     */
+  strBuf_s            batch;
+  gzInflater_p        gz;     /* NULL unless the file is compressed     */
+} lineReader_s, *lineReader_p;
+
+static void gzInflaterStop(gzInflater_p gz) {
+  pthread_mutex_lock(&gz->lock);
+  gz->stop = 1;
+  pthread_cond_broadcast(&gz->cond);
+  pthread_mutex_unlock(&gz->lock);
+  pthread_join(gz->thread, NULL);
+  pthread_mutex_destroy(&gz->lock);
+  pthread_cond_destroy(&gz->cond);
+  free(gz->chunk[0]);
+  free(gz->chunk[1]);
+  free(gz);
+}
+
+static void lineReaderFree(lineReader_p lr) {
+  if (lr == NULL) return;
+  if (lr->gz != NULL) gzInflaterStop(lr->gz);
+  if (lr->base != NULL) munmap(lr->base, lr->size);
+  free(lr->batch.buf);
+  lr->sanity_check = NULL;
+  free(lr);
+}
+
+/* Map a file, without looking at its contents */
+static int32_t lineReaderMap(const char *path, lineReader_p *hnd) {
+  int          fd;
+  struct stat  st;
+  lineReader_p lr;
+  *hnd = NULL;
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return errno;
+  if (fstat(fd, &st)) {
+    int err = errno;
+    close(fd);
+    return err;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+  }
+  lr = (lineReader_p)calloc(1, sizeof(lineReader_s));
+  if (lr == NULL) {
+    close(fd);
+    return ENOMEM;
+  }
+  lr->size = st.st_size;
+  if (lr->size > 0) {
+    void *m = mmap(NULL, lr->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED) {
+      int err = errno;
+      close(fd);
+      free(lr);
+      return err;
+    }
+    lr->base = (char*)m;
+    posix_madvise(m, lr->size, POSIX_MADV_SEQUENTIAL);
+  }
+  /* The mapping survives closing the file */
+  close(fd);
+  lr->sanity_check = lr;
+  *hnd = lr;
+  return 0;
+}
+
+#ifndef SVLIB_NO_ZLIB
+static void *gzInflaterRun(void *arg) {
+  gzInflater_p gz = (gzInflater_p)arg;
+  z_stream     zs;
+  int          idx = 0, zerr = Z_OK;
+  int32_t      err = 0;
+
+  memset(&zs, 0, sizeof(zs));
+  /* 16+MAX_WBITS: expect a gzip header and trailer */
+  if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) err = ENOMEM;
+  zs.next_in  = (Bytef*)gz->src;
+  zs.avail_in = gz->srcSize;
+  while (!err) {
+    pthread_mutex_lock(&gz->lock);
+    while (gz->full[idx] && !gz->stop) pthread_cond_wait(&gz->cond, &gz->lock);
+    if (gz->stop) {
+      pthread_mutex_unlock(&gz->lock);
+      break;
+    }
+    pthread_mutex_unlock(&gz->lock);
+
+    /* chunk[idx] now belongs to this thread until it is marked full */
+    zs.next_out  = (Bytef*)gz->chunk[idx];
+    zs.avail_out = SVLIB_GZ_CHUNK_SIZE;
+    while ((zs.avail_out > 0) && (zs.avail_in > 0)) {
+      zerr = inflate(&zs, Z_NO_FLUSH);
+      if (zerr == Z_STREAM_END) {
+        /* A file may hold several gzip members, one after the other.
+         * Like gzip -d, ignore anything else after a member, such as
+         * the zero padding that some archiving tools add. */
+        if ((zs.avail_in >= 2) && (zs.next_in[0] == 0x1f) && (zs.next_in[1] == 0x8b))
+          inflateReset(&zs);
+        else
+          zs.avail_in = 0;
+      } else if (zerr != Z_OK) {
+        err = (zerr == Z_MEM_ERROR) ? ENOMEM : EILSEQ;
+        break;
+      }
+    }
+    if (!err && (zs.avail_in == 0) && (zerr != Z_STREAM_END)) err = EILSEQ;  /* truncated */
+
+    pthread_mutex_lock(&gz->lock);
+    gz->chunkLen[idx] = SVLIB_GZ_CHUNK_SIZE - zs.avail_out;
+    gz->full[idx]     = 1;
+    if (err || (zs.avail_in == 0)) {
+      gz->eof = 1;
+      gz->err = err;
+    }
+    pthread_cond_broadcast(&gz->cond);
+    pthread_mutex_unlock(&gz->lock);
+    if (gz->eof) break;
+    idx ^= 1;
+  }
+  if (err) {
+    pthread_mutex_lock(&gz->lock);
+    gz->eof = 1;
+    if (!gz->err) gz->err = err;
+    pthread_cond_broadcast(&gz->cond);
+    pthread_mutex_unlock(&gz->lock);
+  }
+  inflateEnd(&zs);
+  return NULL;
+}
+
+static int32_t gzInflaterStart(lineReader_p lr) {
+  gzInflater_p gz = calloc(1, sizeof(gzInflater_s));
+  int32_t      err;
+  if (gz == NULL) return ENOMEM;
+  gz->src      = lr->base;
+  gz->srcSize  = lr->size;
+  gz->chunk[0] = malloc(SVLIB_GZ_CHUNK_SIZE);
+  gz->chunk[1] = malloc(SVLIB_GZ_CHUNK_SIZE);
+  if ((gz->chunk[0] == NULL) || (gz->chunk[1] == NULL)) {
+    free(gz->chunk[0]);
+    free(gz->chunk[1]);
+    free(gz);
+    return ENOMEM;
+  }
+  pthread_mutex_init(&gz->lock, NULL);
+  pthread_cond_init(&gz->cond, NULL);
+  err = pthread_create(&gz->thread, NULL, gzInflaterRun, gz);
+  if (err) {
+    pthread_mutex_destroy(&gz->lock);
+    pthread_cond_destroy(&gz->cond);
+    free(gz->chunk[0]);
+    free(gz->chunk[1]);
+    free(gz);
+    return err;
+  }
+  lr->gz = gz;
+  return 0;
+}
+
+/*
+ * Append the rest of the current line of a compressed file to lr->batch,
+ * moving on to the next chunk as needed. Returns 0 with *got set to
+ * the number of bytes appended (0 at the end of the text), or an errno.
+ */
+static int32_t gzNextLine(lineReader_p lr, size_t *got) {
+  gzInflater_p gz = lr->gz;
+  *got = 0;
+  while (1) {
+    const char *c, *nl;
+    size_t      avail, len;
+    if (!gz->readHeld) {
+      int32_t err;
+      pthread_mutex_lock(&gz->lock);
+      while (!gz->full[gz->readIdx] && !gz->eof) pthread_cond_wait(&gz->cond, &gz->lock);
+      gz->readHeld = gz->full[gz->readIdx];
+      err = gz->err;
+      pthread_mutex_unlock(&gz->lock);
+      if (!gz->readHeld) return err;
+    }
+    c     = gz->chunk[gz->readIdx] + gz->readPos;
+    avail = gz->chunkLen[gz->readIdx] - gz->readPos;
+    nl    = memchr(c, '\n', avail);
+    len   = (nl == NULL) ? avail : (size_t)(nl - c) + 1;
+    if (strBufAppend(&lr->batch, c, len)) return ENOMEM;
+    *got        += len;
+    gz->readPos += len;
+    if (gz->readPos == gz->chunkLen[gz->readIdx]) {
+      /* Hand the chunk back to the inflater */
+      pthread_mutex_lock(&gz->lock);
+      gz->full[gz->readIdx] = 0;
+      pthread_cond_broadcast(&gz->cond);
+      pthread_mutex_unlock(&gz->lock);
+      gz->readHeld = 0;
+      gz->readIdx ^= 1;
+      gz->readPos  = 0;
+    }
+    if (nl != NULL) return 0;
+  }
+}
+#endif
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_lineReaderOpen(
+ *                            input  string  path,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_lineReaderOpen(const char *path, void **hnd) {
+  lineReader_p lr;
+  int32_t      err;
+  *hnd = NULL;
+  err  = lineReaderMap(path, &lr);
+  if (err) return err;
+#ifndef SVLIB_NO_ZLIB
+  if ((lr->size >= 2) && ((unsigned char)lr->base[0] == 0x1f) && ((unsigned char)lr->base[1] == 0x8b)) {
+    err = gzInflaterStart(lr);
+    if (err) {
+      lineReaderFree(lr);
+      return err;
+    }
+  }
+#endif
+  *hnd = (void*)lr;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_lineReaderNext(
+ *                            inout  chandle hnd,
+ *                            output string  lines[],
+ *                            output longint offsets[],
+ *                            output int     n);
+ *----------------------------------------------------------------
+ * Deliver up to lines.size() lines, each with its trailing newline
+ * (if any), and the byte offset within the file of each line's first
+ * character. The number delivered is returned in n. On the first call
+ * that finds no more lines, n==0, the file is unmapped and the handle
+ * is set to null. For a compressed file, a corrupt or truncated
+ * stream gives EILSEQ once the lines before the damage are delivered;
+ * bytes after the last gzip member that do not start another member
+ * are ignored.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_lineReaderNext(
+    void                  **hnd,
+    const svOpenArrayHandle lines,
+    const svOpenArrayHandle offsets,
+    int32_t                *n
+  ) {
+  lineReader_p lr = (lineReader_p)(*hnd);
+  int32_t      i = 0, size, loL, loO, err = 0;
+  size_t       pos, start, end, bpos;
+  const char  *nl;
+
+  *n = 0;
+  if (lr == NULL) return 0;
+  if (lr->sanity_check != lr) return EINVAL;
+
+  size = svSize(lines, 1);
+  if (svSize(offsets, 1) < size) size = svSize(offsets, 1);
+  loL  = svLow(lines, 1);
+  loO  = svLow(offsets, 1);
+
+  /* Copy the lines into the batch buffer, noting where each begins */
+  strBufClear(&lr->batch);
+  pos = lr->pos;
+  if (lr->gz == NULL) {
+    for (i=0; (i<size) && (pos < lr->size); i++) {
+      nl  = memchr(lr->base + pos, '\n', lr->size - pos);
+      end = (nl == NULL) ? lr->size : (size_t)(nl - lr->base) + 1;
+      if (strBufAppend(&lr->batch, lr->base + pos, end - pos)) return ENOMEM;
+      lr->batch.len++;   /* keep the terminating null, start the next line after it */
+      *(int64_t*)svGetArrElemPtr1(offsets, loO+i) = pos;
+      pos = end;
+    }
+  }
+#ifndef SVLIB_NO_ZLIB
+  else {
+    size_t got;
+    for (i=0; i<size; i++) {
+      err = gzNextLine(lr, &got);
+      if (err || (got == 0)) break;
+      lr->batch.len++;
+      *(int64_t*)svGetArrElemPtr1(offsets, loO+i) = pos;
+      pos += got;
+    }
+    /* Deliver any lines before an error; the next call reports it */
+    if (i > 0) err = 0;
+  }
+#endif
+  if (err) return err;
+  if (i == 0) {
+    lineReaderFree(lr);
+    *hnd = NULL;
+    return 0;
+  }
+  *n = i;
+
+  /* The buffer is now complete, so its line pointers are stable */
+  bpos = 0;
+  for (i=0; i<*n; i++) {
+    start = *(int64_t*)svGetArrElemPtr1(offsets, loO+i);
+    end   = (i+1 < *n) ? (size_t)(*(int64_t*)svGetArrElemPtr1(offsets, loO+i+1)) : pos;
+    *(const char**)svGetArrElemPtr1(lines, loL+i) = lr->batch.buf + bpos;
+    bpos += (end - start) + 1;
+  }
+  lr->pos = pos;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_lineReaderClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_lineReaderClose(void **hnd) {
+  lineReader_p lr = (lineReader_p)(*hnd);
+  if ((lr != NULL) && (lr->sanity_check == lr)) {
+    lineReaderFree(lr);
+  }
+  *hnd = NULL;
+}
+
+/*
+ * Results of scanVerilogIntFile, held until scanVerilogIntFetch
+ * copies them into SV arrays of the right size.
+ */
+typedef struct vlogIntResults {
+  struct vlogIntResults * sanity_check;
+  uint32_t              * words;   /* a0 b0 a1 b1 for each value */
+  int8_t                * ok;
+  int32_t                 n;
+} vlogIntResults_s, *vlogIntResults_p;
+
+static void vlogIntResultsFree(vlogIntResults_p r) {
+  if (r == NULL) return;
+  free(r->words);
+  free(r->ok);
+  r->sanity_check = NULL;
+  free(r);
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_scanVerilogIntFile(
+ *                            input  string  path,
+ *                            input  longint startOffset,
+ *                            input  longint length,
+ *                            output chandle hnd,
+ *                            output int     n,
+ *                            output int     nBad);
+ *----------------------------------------------------------------
+ * Scan one literal from each line of a file, from the line that
+ * starts at startOffset up to and including the line that contains
+ * byte startOffset+length-1 (or the end of the file if length<0).
+ * A line that cannot be scanned, including a blank one, gives all x
+ * and ok=0. The n results are held through hnd until fetched.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_scanVerilogIntFile(
+    const char *path,
+    int64_t     startOffset,
+    int64_t     length,
+    void      **hnd,
+    int32_t    *n,
+    int32_t    *nBad
+  ) {
+  lineReader_p     lr;
+  vlogIntResults_p r;
+  size_t           pos, end, lineEnd, max = 0;
+  int32_t          err;
+
+  *hnd  = NULL;
+  *n    = 0;
+  *nBad = 0;
+  if (startOffset < 0) return EINVAL;
+  err = lineReaderMap(path, &lr);
+  if (err) return err;
+  r   = calloc(1, sizeof(vlogIntResults_s));
+  if (r == NULL) {
+    lineReaderFree(lr);
+    return ENOMEM;
+  }
+  r->sanity_check = r;
+
+  pos = (startOffset < (int64_t)lr->size) ? (size_t)startOffset : lr->size;
+  end = ((length < 0) || (startOffset + length > (int64_t)lr->size)) ? lr->size : (size_t)(startOffset + length);
+  while (pos < end) {
+    const char *nl = memchr(lr->base + pos, '\n', lr->size - pos);
+    lineEnd = (nl == NULL) ? lr->size : (size_t)(nl - lr->base);
+    if ((size_t)r->n == max) {
+      size_t    newMax = max ? 2*max : 1024;
+      uint32_t *w = realloc(r->words, newMax * 4 * sizeof(uint32_t));
+      int8_t   *k = (w == NULL) ? NULL : realloc(r->ok, newMax);
+      if (w != NULL) r->words = w;
+      if (k == NULL) {
+        err = ENOMEM;
+        break;
+      }
+      r->ok = k;
+      max   = newMax;
+    }
+    {
+      uint32_t a[2], b[2];
+      int      good = verilogIntScan(lr->base + pos, lineEnd - pos, 64, a, b);
+      uint32_t *w   = r->words + 4 * r->n;
+      if (!good) {
+        a[0] = a[1] = b[0] = b[1] = ~0u;
+        (*nBad)++;
+      }
+      w[0] = a[0];  w[1] = b[0];  w[2] = a[1];  w[3] = b[1];
+      r->ok[r->n++] = good;
+    }
+    pos = lineEnd + 1;
+  }
+  lineReaderFree(lr);
+  if (err) {
+    vlogIntResultsFree(r);
+    *nBad = 0;
+    return err;
+  }
+  *n   = r->n;
+  *hnd = (void*)r;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function void svlib_dpi_imported_scanVerilogIntFetch(
+ *                            inout  chandle     hnd,
+ *                            output logic[63:0] values[],
+ *                            output byte        ok[]);
+ *----------------------------------------------------------------
+ * Copy the results of scanVerilogIntFile, which must fit, and free them.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_scanVerilogIntFetch(
+    void                  **hnd,
+    const svOpenArrayHandle values,
+    const svOpenArrayHandle ok
+  ) {
+  vlogIntResults_p r = (vlogIntResults_p)(*hnd);
+  int32_t          i, n, loV, loK;
+  if ((r == NULL) || (r->sanity_check != r)) return;
+  n = r->n;
+  if (svSize(values, 1) < n) n = svSize(values, 1);
+  if (svSize(ok, 1) < n)     n = svSize(ok, 1);
+  loV = svLow(values, 1);
+  loK = svLow(ok, 1);
+  for (i=0; i<n; i++) {
+    svLogicVecVal *v = (svLogicVecVal*)svGetArrElemPtr1(values, loV+i);
+    uint32_t      *w = r->words + 4*i;
+    v[0].aval = w[0];  v[0].bval = w[1];
+    v[1].aval = w[2];  v[1].bval = w[3];
+    *(int8_t*)svGetArrElemPtr1(ok, loK+i) = r->ok[i];
+  }
+  vlogIntResultsFree(r);
+  *hnd = NULL;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Lexer for .INI files, for cfgFileINI::deserialize. It works over a
+ * lineReader's mapping and hands back records of kind INI_RECORD_ENUM.
+ * Each line is first right-trimmed of the characters that Str::trim
+ * removes; blank lines yield no record. Then the line is classified
+ * exactly as these three regular expressions, tried in order, would
+ * classify it (these are the ones cfgFileINI used to apply to each line):
+ *    comment: ^\s*[;#]\s?(.*)$
+ *    section: ^\s*\[\s*(\w+)\s*\]$
+ *    key/val: ^\s*(\w+)\s*[=:]\s*((.*[^ '"])|(['"])(.*)\4)\s*$
+ * Lines are matched by hand, except that a line containing \v or \f
+ * (which \s matches but Str::trim leaves alone) is given to the real
+ * regular expressions, because then the choice between the alternatives
+ * of the key/val value is subtle.
+ */
+static const char * const iniRegexSource[3] = {
+  "^\\s*[;#]\\s?(.*)$",
+  "^\\s*\\[\\s*(\\w+)\\s*\\]$",
+  "^\\s*(\\w+)\\s*[=:]\\s*((.*[^ '\"])|(['\"])(.*)\\4)\\s*$"
+};
+static regex_t         iniRegex[3];
+static int             iniRegexError = 0;
+static pthread_once_t  iniRegexOnce  = PTHREAD_ONCE_INIT;
+
+/* Compiled once, by whichever thread first needs them */
+static void iniRegexCompile(void) {
+  int r;
+  for (r=0; r<3; r++) {
+    if (regcomp(&iniRegex[r], iniRegexSource[r], REG_EXTENDED)) {
+      while (r-- > 0) regfree(&iniRegex[r]);
+      iniRegexError = EINVAL;
+      return;
+    }
+  }
+}
+
+#define iniIsS(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\v' || (c)=='\f' || (c)=='\r')
+#define iniIsW(c) ((((c)|0x20) >= 'a' && ((c)|0x20) <= 'z') || ((c) >= '0' && (c) <= '9') || (c)=='_')
+
+typedef struct iniLexer {
+  struct iniLexer * sanity_check;
+  lineReader_p      lr;
+  int32_t           lineNum;
+  strBuf_s          batch;
+  strBuf_s          scratch;  /* null-terminated copy of a line, for regexec */
+  size_t          * lens;     /* text1/text2 lengths of each record in batch */
+  size_t            lensSize;
+} iniLexer_s, *iniLexer_p;
+
+static void iniLexerFree(iniLexer_p lx) {
+  if (lx == NULL) return;
+  svlib_dpi_imported_lineReaderClose((void**)&(lx->lr));
+  free(lx->batch.buf);
+  free(lx->scratch.buf);
+  free(lx->lens);
+  lx->sanity_check = NULL;
+  free(lx);
+}
+
+/* Classify one trimmed, non-empty line. Sets [*s1,*e1) and [*s2,*e2)
+ * to the positions of text1 and text2 within the line. */
+static int32_t iniClassifyLine(iniLexer_p lx, const char *line, size_t len,
+                               size_t *s1, size_t *e1, size_t *s2, size_t *e2, int32_t *kind) {
+  size_t i, j;
+  char   q;
+  *s1 = *e1 = *s2 = *e2 = 0;
+
+  if ((memchr(line, '\v', len) != NULL) || (memchr(line, '\f', len) != NULL)) {
+    regmatch_t m[6];
+    int        r;
+    pthread_once(&iniRegexOnce, iniRegexCompile);
+    if (iniRegexError) return iniRegexError;
+    strBufClear(&lx->scratch);
+    if (strBufAppend(&lx->scratch, line, len)) return ENOMEM;
+    for (r=0; r<3; r++) {
+      if (0 == regexec(&iniRegex[r], lx->scratch.buf, 6, m, 0)) break;
+    }
+    switch (r) {
+      case 0:
+      case 1:
+        *kind = (r == 0) ? iniCOMMENT : iniSECTION;
+        *s1 = m[1].rm_so;  *e1 = m[1].rm_eo;
+        break;
+      case 2:
+        *kind = iniKEYVAL;
+        *s1 = m[1].rm_so;  *e1 = m[1].rm_eo;
+        if (m[3].rm_so >= 0) {
+          *s2 = m[3].rm_so;  *e2 = m[3].rm_eo;
+        } else {
+          *s2 = m[5].rm_so;  *e2 = m[5].rm_eo;
+        }
+        break;
+      default:
+        *kind = iniBADSYNTAX;
+        *e1 = len;
+        break;
+    }
+    return 0;
+  }
+
+  /* Without \v or \f, the trimmed line cannot end in a \s character */
+  i = 0;
+  while ((i < len) && iniIsS(line[i])) i++;
+
+  if ((line[i] == ';') || (line[i] == '#')) {
+    i++;
+    if ((i < len) && iniIsS(line[i])) i++;
+    *kind = iniCOMMENT;
+    *s1 = i;  *e1 = len;
+    return 0;
+  }
+
+  if (line[i] == '[') {
+    i++;
+    while ((i < len) && iniIsS(line[i])) i++;
+    j = i;
+    while ((j < len) && iniIsW(line[j])) j++;
+    if ((j > i) && (line[len-1] == ']')) {
+      size_t k = j;
+      while ((k < len-1) && iniIsS(line[k])) k++;
+      if (k == len-1) {
+        *kind = iniSECTION;
+        *s1 = i;  *e1 = j;
+        return 0;
+      }
+    }
+  } else {
+    j = i;
+    while ((j < len) && iniIsW(line[j])) j++;
+    if (j > i) {
+      *s1 = i;  *e1 = j;
+      while ((j < len) && iniIsS(line[j])) j++;
+      if ((j < len) && ((line[j] == '=') || (line[j] == ':'))) {
+        j++;
+        while ((j < len) && iniIsS(line[j])) j++;
+        /* The value is line[j..len-1], and is not empty unless j==len */
+        q = line[len-1];
+        if (j == len) {
+          /* no value: bad syntax */
+        } else if ((q != '\'') && (q != '"')) {
+          *kind = iniKEYVAL;
+          *s2 = j;  *e2 = len;
+          return 0;
+        } else if ((len-j >= 2) && (line[j] == q)) {
+          *kind = iniKEYVAL;
+          *s2 = j+1;  *e2 = len-1;
+          return 0;
+        }
+      }
+    }
+  }
+  *kind = iniBADSYNTAX;
+  *s1 = 0;  *e1 = len;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_iniLexerOpen(
+ *                            input  string  path,
+ *                            input  longint startOffset,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_iniLexerOpen(const char *path, int64_t startOffset, void **hnd) {
+  int32_t    err;
+  iniLexer_p lx;
+  *hnd = NULL;
+  lx = (iniLexer_p)calloc(1, sizeof(iniLexer_s));
+  if (lx == NULL) return ENOMEM;
+  err = lineReaderMap(path, &(lx->lr));
+  if (err) {
+    free(lx);
+    return err;
+  }
+  if (startOffset > 0) {
+    lx->lr->pos = ((uint64_t)startOffset < lx->lr->size) ? (size_t)startOffset : lx->lr->size;
+  }
+  lx->sanity_check = lx;
+  *hnd = (void*)lx;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_iniLexerNext(
+ *                            inout  chandle hnd,
+ *                            output int     kinds[],
+ *                            output int     lineNums[],
+ *                            output string  text1[],
+ *                            output string  text2[],
+ *                            output int     n);
+ *----------------------------------------------------------------
+ * Deliver up to kinds.size() records. As with lineReaderNext, the
+ * call that finds no more records returns n==0, releases the file
+ * and sets the handle to null.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_iniLexerNext(
+    void                  **hnd,
+    const svOpenArrayHandle kinds,
+    const svOpenArrayHandle lineNums,
+    const svOpenArrayHandle text1,
+    const svOpenArrayHandle text2,
+    int32_t                *n
+  ) {
+  iniLexer_p   lx = (iniLexer_p)(*hnd);
+  lineReader_p lr;
+  int32_t      i, size, err, kind;
+  size_t       pos, end, len, s1, e1, s2, e2, bpos;
+  const char  *line, *nl;
+  int          loK, loL, lo1, lo2;
+
+  *n = 0;
+  if (lx == NULL) return 0;
+  if (lx->sanity_check != lx) return EINVAL;
+  lr = lx->lr;
+
+  size = svSize(kinds, 1);
+  loK  = svLow(kinds, 1);
+  loL  = svLow(lineNums, 1);
+  lo1  = svLow(text1, 1);
+  lo2  = svLow(text2, 1);
+
+  if (lx->lensSize < 2*(size_t)size) {
+    size_t *p = realloc(lx->lens, 2*size*sizeof(size_t));
+    if (p == NULL) return ENOMEM;
+    lx->lens     = p;
+    lx->lensSize = 2*size;
+  }
+
+  /* First pass: lex lines into the batch buffer, noting text lengths */
+  strBufClear(&lx->batch);
+  pos = lr->pos;
+  i   = 0;
+  while ((i < size) && (pos < lr->size)) {
+    line = lr->base + pos;
+    nl   = memchr(line, '\n', lr->size - pos);
+    end  = (nl == NULL) ? lr->size : (size_t)(nl - lr->base) + 1;
+    len  = end - pos;
+    pos  = end;
+    lx->lineNum++;
+    while ((len > 0) && charSetHas(&charSetSpace, line[len-1])) len--;
+    if (len == 0) continue;
+    err = iniClassifyLine(lx, line, len, &s1, &e1, &s2, &e2, &kind);
+    if (!err) err = strBufAppend(&lx->batch, line+s1, e1-s1);
+    if (!err) lx->batch.len++;
+    if (!err) err = strBufAppend(&lx->batch, line+s2, e2-s2);
+    if (!err) lx->batch.len++;
+    if (err) return err;
+    *(int32_t*)svGetArrElemPtr1(kinds,    loK+i) = kind;
+    *(int32_t*)svGetArrElemPtr1(lineNums, loL+i) = lx->lineNum;
+    lx->lens[2*i]   = e1-s1;
+    lx->lens[2*i+1] = e2-s2;
+    i++;
+  }
+  lr->pos = pos;
+  *n = i;
+
+  if (i == 0) {
+    iniLexerFree(lx);
+    *hnd = NULL;
+    return 0;
+  }
+
+  /* Second pass: the buffer is complete, so point at its strings */
+  bpos = 0;
+  for (i=0; i<*n; i++) {
+    *(const char**)svGetArrElemPtr1(text1, lo1+i) = lx->batch.buf + bpos;
+    bpos += lx->lens[2*i] + 1;
+    *(const char**)svGetArrElemPtr1(text2, lo2+i) = lx->batch.buf + bpos;
+    bpos += lx->lens[2*i+1] + 1;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_iniLexerClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_iniLexerClose(void **hnd) {
+  iniLexer_p lx = (iniLexer_p)(*hnd);
+  if ((lx != NULL) && (lx->sanity_check == lx)) {
+    iniLexerFree(lx);
+  }
+  *hnd = NULL;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Streaming YAML parser, for cfgFileYAML::deserialize. It reads a
+ * lineReader's mapping one line at a time and produces events of kind
+ * YAML_EVENT_ENUM into a queue, from which yamlParserNext hands out
+ * batches. Only as much of the file is parsed as is needed to fill
+ * each batch, so memory use is bounded by nesting depth and batch size.
+ *
+ * The supported subset is what is needed to represent a cfgNode DOM:
+ * one document (optionally starting with ---, ending at ... or EOF);
+ * block mappings and sequences, including compact "- key: value" and
+ * "- - item" forms and sequences at the same indent as their parent key;
+ * flow [...] and {...} collections, which may span lines; plain,
+ * 'single-quoted' and "double-quoted" scalars; literal | and folded >
+ * block scalars with - and + chomping; and full-line # comments, which
+ * are reported so that they can be attached to the following node.
+ * Anchors, aliases, tags, directives, complex ? keys and plain scalars
+ * continued over several lines are reported as errors.
+ * A plain scalar that is a decimal or 0x-prefixed hex integer within
+ * 64-bit range is flagged as an integer, with its value.
+ */
+typedef struct yamlEvent {
+  int32_t kind;
+  int32_t line;
+  int32_t isInt;
+  int64_t intValue;
+  size_t  key;       /* offsets of null-terminated strings in yamlParser.strs */
+  size_t  text;
+} yamlEvent_s, *yamlEvent_p;
+
+typedef struct yamlLevel {
+  int32_t indent;
+  int32_t isSeq;
+  int32_t sameIndent; /* a block sequence at the same indent as its key */
+} yamlLevel_s, *yamlLevel_p;
+
+typedef struct yamlParser {
+  struct yamlParser * sanity_check;
+  lineReader_p        lr;
+  int32_t             lineNum;
+  int32_t             started;     /* seen any content yet?                */
+  int32_t             rootDone;    /* root was a scalar, nothing may follow */
+  int32_t             finished;
+  int32_t             noBreak;     /* current line is last, with no '\n'   */
+
+  yamlEvent_p         ev;          /* event queue is ev[evHead..nEv-1]     */
+  size_t              evHead, nEv, evSize;
+  strBuf_s            strs;        /* strings belonging to queued events   */
+
+  yamlLevel_p         stack;
+  int32_t             depth, stackSize;
+
+  /* "key:" or "-" with nothing after it; what it is depends on the next line */
+  int32_t             pending;
+  int32_t             pendingIndent;
+  int32_t             pendingFromSeq;
+  int32_t             pendingLine;
+  strBuf_s            pendingKey;
+  /* comments seen while pending are held back, from ev[holdFrom] on, so
+   * that they can follow the event that the pending line turns into */
+  int32_t             holding;
+  size_t              holdFrom;
+
+  /* block scalar being collected */
+  int32_t             block;       /* '|' or '>' or 0                      */
+  int32_t             blockChomp;  /* '-', '+' or 0 for clip                */
+  int32_t             blockParent; /* indent of the owning key or item     */
+  int32_t             blockIndent; /* 0 until the first non-blank line     */
+  int32_t             blockBlanks; /* blank lines not yet added            */
+  int32_t             blockLastMore; /* last line was more-indented (folding) */
+  int32_t             blockNoBreak;  /* last line had no line break          */
+  int32_t             blockLine;
+  strBuf_s            blockKey;
+  strBuf_s            blockText;
+
+  /* flow collection spanning several lines */
+  int32_t             flow;
+  int32_t             flowDepth;
+  int32_t             flowQuote;   /* quote character we're inside, or 0  */
+  int32_t             flowTokenStart; /* could a quoted scalar start here?  */
+  int32_t             flowParent;
+  int32_t             flowLine;
+  strBuf_s            flowKey;
+  strBuf_s            flowText;
+
+  strBuf_s            scratch;
+  size_t            * lens;
+  size_t              lensSize;
+} yamlParser_s, *yamlParser_p;
+
+static int32_t yamlEmit(yamlParser_p p, int32_t kind, int32_t line,
+                        const char *key, size_t keyLen,
+                        const char *text, size_t textLen,
+                        int32_t isInt, int64_t intValue) {
+  yamlEvent_p e;
+  if (p->nEv >= p->evSize) {
+    size_t      newSize = p->evSize ? 2*p->evSize : 256;
+    yamlEvent_p n = realloc(p->ev, newSize * sizeof(yamlEvent_s));
+    if (n == NULL) return ENOMEM;
+    p->ev     = n;
+    p->evSize = newSize;
+  }
+  e = &(p->ev[p->nEv]);
+  e->kind     = kind;
+  e->line     = line;
+  e->isInt    = isInt;
+  e->intValue = intValue;
+  e->key      = p->strs.len;
+  if (strBufAppend(&p->strs, key, keyLen)) return ENOMEM;
+  p->strs.len++;
+  e->text     = p->strs.len;
+  if (strBufAppend(&p->strs, text, textLen)) return ENOMEM;
+  p->strs.len++;
+  p->nEv++;
+  return 0;
+}
+
+static int32_t yamlError(yamlParser_p p, int32_t line, const char *msg) {
+  p->finished = 1;
+  p->holding  = 0;
+  return yamlEmit(p, yamlERROR, line, "", 0, msg, strlen(msg), 0, 0);
+}
+
+/* The event just emitted resolves a pending line: move it in front of
+ * any comments that were held back, and let them go */
+static void yamlReleaseHeld(yamlParser_p p) {
+  yamlEvent_s e;
+  if (!p->holding) return;
+  e = p->ev[p->nEv-1];
+  memmove(p->ev + p->holdFrom + 1, p->ev + p->holdFrom,
+          (p->nEv - 1 - p->holdFrom) * sizeof(yamlEvent_s));
+  p->ev[p->holdFrom] = e;
+  p->holding = 0;
+}
+
+static int32_t yamlPush(yamlParser_p p, int32_t indent, int32_t isSeq, int32_t sameIndent,
+                        const char *key, size_t keyLen) {
+  if (p->depth >= p->stackSize) {
+    int32_t     newSize = p->stackSize ? 2*p->stackSize : 32;
+    yamlLevel_p n = realloc(p->stack, newSize * sizeof(yamlLevel_s));
+    if (n == NULL) return ENOMEM;
+    p->stack     = n;
+    p->stackSize = newSize;
+  }
+  p->stack[p->depth].indent     = indent;
+  p->stack[p->depth].isSeq      = isSeq;
+  p->stack[p->depth].sameIndent = sameIndent;
+  p->depth++;
+  return yamlEmit(p, isSeq ? yamlSEQSTART : yamlMAPSTART, p->lineNum, key, keyLen, "", 0, 0, 0);
+}
+
+static int32_t yamlPop(yamlParser_p p) {
+  p->depth--;
+  return yamlEmit(p, p->stack[p->depth].isSeq ? yamlSEQEND : yamlMAPEND, p->lineNum, "", 0, "", 0, 0, 0);
+}
+
+/* Is s[0..n-1] a decimal or 0x hex integer in 64-bit range? */
+static int32_t yamlIsInt(const char *s, size_t n, int64_t *value) {
+  size_t   i = 0;
+  int      neg = 0;
+  uint64_t v = 0, limit;
+  if ((n > 0) && ((s[0] == '-') || (s[0] == '+'))) {
+    neg = (s[0] == '-');
+    i++;
+  }
+  if (i >= n) return 0;
+  limit = neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  if ((n-i > 2) && (s[i] == '0') && ((s[i+1] == 'x') || (s[i+1] == 'X'))) {
+    for (i += 2; i < n; i++) {
+      int d;
+      if      ((s[i] >= '0') && (s[i] <= '9')) d = s[i] - '0';
+      else if ((s[i] >= 'a') && (s[i] <= 'f')) d = s[i] - 'a' + 10;
+      else if ((s[i] >= 'A') && (s[i] <= 'F')) d = s[i] - 'A' + 10;
+      else return 0;
+      if (v > (limit - d) / 16) return 0;
+      v = 16*v + d;
+    }
+  } else {
+    for (; i < n; i++) {
+      if ((s[i] < '0') || (s[i] > '9')) return 0;
+      if (v > (limit - (s[i]-'0')) / 10) return 0;
+      v = 10*v + (s[i]-'0');
+    }
+  }
+  *value = neg ? (int64_t)(0 - v) : (int64_t)v;
+  return 1;
+}
+
+/* Is there a comment (or nothing) at s[i..n-1]? */
+static int yamlRestIsEmpty(const char *s, size_t i, size_t n) {
+  while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+  return (i == n) || (s[i] == '#');
+}
+
+static int yamlIsSeqItem(const char *s, size_t n) {
+  return (n > 0) && (s[0] == '-') && ((n == 1) || (s[1] == ' '));
+}
+
+/* Decode a quoted scalar starting at s[*pos] (the quote) into p->scratch.
+ * On success *pos is just after the closing quote; returns an error
+ * message or NULL. */
+static const char* yamlQuoted(yamlParser_p p, const char *s, size_t n, size_t *pos) {
+  char   q = s[*pos];
+  size_t i = *pos + 1;
+  strBufClear(&p->scratch);
+  if (strBufAppend(&p->scratch, "", 0)) return "out of memory";
+  while (i < n) {
+    char c = s[i];
+    if (c == q) {
+      if ((q == '\'') && (i+1 < n) && (s[i+1] == '\'')) {
+        if (strBufAppend(&p->scratch, "'", 1)) return "out of memory";
+        i += 2;
+        continue;
+      }
+      *pos = i+1;
+      return NULL;
+    }
+    if ((q == '"') && (c == '\\')) {
+      char     e;
+      unsigned u = 0;
+      int      digits = 0, k;
+      if (++i >= n) break;
+      e = s[i++];
+      switch (e) {
+        case 'n':  c = '\n'; break;
+        case 't':  c = '\t'; break;
+        case 'r':  c = '\r'; break;
+        case 'a':  c = '\a'; break;
+        case 'b':  c = '\b'; break;
+        case 'e':  c = 27;   break;
+        case 'f':  c = '\f'; break;
+        case 'v':  c = '\v'; break;
+        case '"':  case '\\': case '/': case ' ': c = e; break;
+        case 'x':  digits = 2; break;
+        case 'u':  digits = 4; break;
+        case 'U':  digits = 8; break;
+        default:   return "unsupported escape sequence in double-quoted string";
+      }
+      if (digits) {
+        for (k=0; k<digits; k++, i++) {
+          int d;
+          if (i >= n) return "bad escape sequence in double-quoted string";
+          if      ((s[i] >= '0') && (s[i] <= '9')) d = s[i] - '0';
+          else if ((s[i] >= 'a') && (s[i] <= 'f')) d = s[i] - 'a' + 10;
+          else if ((s[i] >= 'A') && (s[i] <= 'F')) d = s[i] - 'A' + 10;
+          else return "bad escape sequence in double-quoted string";
+          u = 16*u + d;
+        }
+        if (u == 0) return "null character cannot be represented in a string";
+        if (u < 0x80) {
+          c = (char)u;
+        } else {
+          /* UTF-8 encode */
+          char b[4];
+          int  nb;
+          if (u < 0x800)        { b[0] = 0xC0 | (u>>6);  nb = 2; }
+          else if (u < 0x10000) { b[0] = 0xE0 | (u>>12); nb = 3; }
+          else                  { b[0] = 0xF0 | (u>>18); nb = 4; }
+          for (k=1; k<nb; k++) b[k] = 0x80 | ((u >> (6*(nb-1-k))) & 0x3F);
+          if (strBufAppend(&p->scratch, b, nb)) return "out of memory";
+          continue;
+        }
+      }
+      if (strBufAppend(&p->scratch, &c, 1)) return "out of memory";
+      continue;
+    }
+    if (strBufAppend(&p->scratch, &c, 1)) return "out of memory";
+    i++;
+  }
+  return "quoted string must end on the same line";
+}
+
+/* Does s[0..n-1] start with an indicator we don't support? */
+static const char* yamlUnsupported(const char *s, size_t n) {
+  switch (s[0]) {
+    case '&': return "anchors are not supported";
+    case '*': return "aliases are not supported";
+    case '!': return "tags are not supported";
+    case '?': /* ?x is a plain scalar */
+      if ((n > 1) && (s[1] != ' ') && (s[1] != '\t')) return NULL;
+      return "complex mapping keys are not supported";
+    case '%': return "directives are not supported";
+    case '@': case '`': return "reserved indicator character";
+    default:  return NULL;
+  }
+}
+
+/* Emit a scalar event for plain or quoted text at s[*pos], stopping at
+ * any of the characters in stop (flow context) or at a comment. */
+static int32_t yamlScalar(yamlParser_p p, const char *key, size_t keyLen,
+                          const char *s, size_t n, size_t *pos, const char *stop,
+                          const char **msg) {
+  size_t  i = *pos, end;
+  int32_t isInt;
+  int64_t v = 0;
+  *msg = NULL;
+  if ((s[i] == '"') || (s[i] == '\'')) {
+    *msg = yamlQuoted(p, s, n, pos);
+    if (*msg) return 0;
+    return yamlEmit(p, yamlSCALAR, p->lineNum, key, keyLen, p->scratch.buf, p->scratch.len, 0, 0);
+  }
+  if ((*msg = yamlUnsupported(s+i, n-i)) != NULL) return 0;
+  end = i;
+  while ((end < n) && !strchr(stop, s[end]) &&
+         !((s[end] == '#') && (end > i) && (s[end-1] == ' ' || s[end-1] == '\t'))) end++;
+  *pos = end;
+  while ((end > i) && (s[end-1] == ' ' || s[end-1] == '\t')) end--;
+  isInt = yamlIsInt(s+i, end-i, &v);
+  return yamlEmit(p, yamlSCALAR, p->lineNum, key, keyLen, s+i, end-i, isInt, v);
+}
+
+/* Parse one flow node at s[*pos], whose key (if in a map) is key */
+static int32_t yamlFlowNode(yamlParser_p p, const char *key, size_t keyLen,
+                            const char *s, size_t n, size_t *pos, const char **msg) {
+  int32_t err;
+  size_t  i = *pos;
+  *msg = NULL;
+  while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+  if (i >= n) { *msg = "missing value in flow collection"; return 0; }
+  if ((s[i] == '[') || (s[i] == '{')) {
+    int  isSeq = (s[i] == '[');
+    char close = isSeq ? ']' : '}';
+    err = yamlEmit(p, isSeq ? yamlSEQSTART : yamlMAPSTART, p->lineNum, key, keyLen, "", 0, 0, 0);
+    if (err) return err;
+    i++;
+    while (1) {
+      while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+      if (i >= n) { *msg = "unterminated flow collection"; return 0; }
+      if (s[i] == close) { i++; break; }
+      if (isSeq) {
+        err = yamlFlowNode(p, "", 0, s, n, &i, msg);
+      } else {
+        /* key, then ':' then value; a missing value is an empty string */
+        size_t ks, ke;
+        char  *k;
+        if ((s[i] == '"') || (s[i] == '\'')) {
+          *msg = yamlQuoted(p, s, n, &i);
+          if (*msg) return 0;
+        } else {
+          if ((*msg = yamlUnsupported(s+i, n-i)) != NULL) return 0;
+          ks = i;
+          while ((i < n) && !strchr(",[]{}", s[i]) &&
+                 !((s[i] == ':') && ((i+1 >= n) || strchr(" \t,]}", s[i+1])))) i++;
+          ke = i;
+          while ((ke > ks) && (s[ke-1] == ' ' || s[ke-1] == '\t')) ke--;
+          strBufClear(&p->scratch);
+          if (strBufAppend(&p->scratch, s+ks, ke-ks)) return ENOMEM;
+        }
+        /* the key must survive parsing the value, which reuses scratch */
+        k = strdup(p->scratch.buf);
+        if (k == NULL) return ENOMEM;
+        while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+        if ((i < n) && (s[i] == ':')) {
+          i++;
+          while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+        }
+        if ((i < n) && ((s[i] == ',') || (s[i] == '}'))) {
+          err = yamlEmit(p, yamlSCALAR, p->lineNum, k, strlen(k), "", 0, 0, 0);
+        } else {
+          err = yamlFlowNode(p, k, strlen(k), s, n, &i, msg);
+        }
+        free(k);
+      }
+      if (err || *msg) return err;
+      while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+      if ((i < n) && (s[i] == ',')) {
+        i++;
+      } else if ((i >= n) || (s[i] != close)) {
+        *msg = "expected ',' or end of flow collection";
+        return 0;
+      }
+    }
+    err = yamlEmit(p, isSeq ? yamlSEQEND : yamlMAPEND, p->lineNum, "", 0, "", 0, 0, 0);
+    *pos = i;
+    return err;
+  }
+  err = yamlScalar(p, key, keyLen, s, n, &i, ",[]{}", msg);
+  *pos = i;
+  return err;
+}
+
+/* Parse a complete flow collection (possibly gathered from several lines) */
+static int32_t yamlFlowValue(yamlParser_p p, const char *key, size_t keyLen,
+                             const char *s, size_t n, int32_t line) {
+  size_t      pos = 0;
+  const char *msg;
+  int32_t     saveLine = p->lineNum;
+  int32_t     err;
+  p->lineNum = line;
+  err = yamlFlowNode(p, key, keyLen, s, n, &pos, &msg);
+  p->lineNum = saveLine;
+  if (err) return err;
+  if (msg == NULL && !yamlRestIsEmpty(s, pos, n)) msg = "unexpected text after flow collection";
+  if (msg) return yamlError(p, line, msg);
+  return 0;
+}
+
+/* Scan more flow text, tracking bracket depth and quoting. A quote
+ * only opens a quoted scalar at the start of a token; elsewhere it is
+ * part of a plain scalar. Stops at a comment, returning the length of
+ * text that belongs to the flow. */
+static size_t yamlFlowScan(yamlParser_p p, const char *s, size_t n) {
+  size_t i;
+  for (i=0; i<n; i++) {
+    char c = s[i];
+    if (p->flowQuote) {
+      if ((p->flowQuote == '"') && (c == '\\')) { i++; continue; }
+      if ((p->flowQuote == '\'') && (c == '\'') && (i+1 < n) && (s[i+1] == '\'')) { i++; continue; }
+      if (c == p->flowQuote) {
+        p->flowQuote      = 0;
+        p->flowTokenStart = 0;
+      }
+      continue;
+    }
+    if ((c == ' ') || (c == '\t')) continue;
+    if ((c == '#') && ((i == 0) || (s[i-1] == ' ') || (s[i-1] == '\t'))) return i;
+    if (((c == '"') || (c == '\'')) && p->flowTokenStart) {
+      p->flowQuote = c;
+    } else if ((c == '[') || (c == '{')) {
+      p->flowDepth++;
+    } else if ((c == ']') || (c == '}')) {
+      p->flowDepth--;
+    }
+    p->flowTokenStart = (c == '[') || (c == '{') || (c == ',') || (c == ':');
+  }
+  return n;
+}
+
+/* Start a flow collection; finish it now if it is all on this line */
+static int32_t yamlFlowStart(yamlParser_p p, const char *key, size_t keyLen,
+                             const char *s, size_t n, int32_t parentIndent) {
+  size_t used;
+  p->flowDepth      = 0;
+  p->flowQuote      = 0;
+  p->flowTokenStart = 1;
+  used = yamlFlowScan(p, s, n);
+  if ((p->flowDepth <= 0) && !p->flowQuote) {
+    return yamlFlowValue(p, key, keyLen, s, n, p->lineNum);
+  }
+  p->flow       = 1;
+  p->flowParent = parentIndent;
+  p->flowLine   = p->lineNum;
+  strBufClear(&p->flowKey);
+  strBufClear(&p->flowText);
+  if (strBufAppend(&p->flowKey, key, keyLen)) return ENOMEM;
+  if (strBufAppend(&p->flowText, s, used)) return ENOMEM;
+  return 0;
+}
+
+static int32_t yamlFlowContinue(yamlParser_p p, const char *s, size_t n) {
+  size_t  used;
+  int32_t err;
+  if (p->flowQuote) return yamlError(p, p->lineNum, "quoted string must end on the same line");
+  used = yamlFlowScan(p, s, n);
+  if (strBufAppend(&p->flowText, " ", 1)) return ENOMEM;
+  if (strBufAppend(&p->flowText, s, used)) return ENOMEM;
+  if ((p->flowDepth > 0) || p->flowQuote) return 0;
+  p->flow = 0;
+  err = yamlFlowValue(p, p->flowKey.buf, p->flowKey.len, p->flowText.buf, p->flowText.len, p->flowLine);
+  return err;
+}
+
+/* Block scalars */
+static int32_t yamlBlockFinish(yamlParser_p p) {
+  int32_t i, err;
+  p->block = 0;
+  /* the file's last line may have no line break to keep */
+  if (p->blockNoBreak && (p->blockBlanks > 0)) {
+    p->blockBlanks--;
+    p->blockNoBreak = 0;
+  }
+  if (p->blockChomp != '-' && p->blockText.len > 0 && !p->blockNoBreak) {
+    if (strBufAppend(&p->blockText, "\n", 1)) return ENOMEM;
+  }
+  if (p->blockChomp == '+') {
+    for (i=0; i<p->blockBlanks; i++) {
+      if (strBufAppend(&p->blockText, "\n", 1)) return ENOMEM;
+    }
+  }
+  err = yamlEmit(p, yamlSCALAR, p->blockLine, p->blockKey.buf, p->blockKey.len,
+                 p->blockText.buf ? p->blockText.buf : "", p->blockText.len, 0, 0);
+  return err;
+}
+
+/* Returns 1 if the line (raw, without newline) was absorbed into the block */
+static int32_t yamlBlockLine(yamlParser_p p, const char *s, size_t n, int32_t *absorbed) {
+  int32_t ind = 0, i;
+  int     more;
+  *absorbed = 0;
+  while ((ind < (int32_t)n) && (s[ind] == ' ')) ind++;
+  if (ind == (int32_t)n) {
+    p->blockBlanks++;
+    p->blockNoBreak = p->noBreak;
+    *absorbed = 1;
+    return 0;
+  }
+  if (p->blockIndent == 0) {
+    if (ind <= p->blockParent) return yamlBlockFinish(p);
+    p->blockIndent = ind;
+  }
+  if (ind < p->blockIndent) return yamlBlockFinish(p);
+  *absorbed = 1;
+  more = (ind > p->blockIndent) || (s[p->blockIndent] == ' ') || (s[p->blockIndent] == '\t');
+  if (p->blockText.len > 0) {
+    if (p->block == '|') {
+      for (i=0; i<=p->blockBlanks; i++) {
+        if (strBufAppend(&p->blockText, "\n", 1)) return ENOMEM;
+      }
+    } else {
+      /* folded: a single line break becomes a space, except around
+       * more-indented lines; each blank line is one newline */
+      if ((p->blockBlanks == 0) && !more && !p->blockLastMore) {
+        if (strBufAppend(&p->blockText, " ", 1)) return ENOMEM;
+      } else {
+        int nl = p->blockBlanks + ((more || p->blockLastMore) ? 1 : 0);
+        for (i=0; i<nl; i++) {
+          if (strBufAppend(&p->blockText, "\n", 1)) return ENOMEM;
+        }
+      }
+    }
+  } else {
+    for (i=0; i<p->blockBlanks; i++) {
+      if (strBufAppend(&p->blockText, "\n", 1)) return ENOMEM;
+    }
+  }
+  p->blockBlanks   = 0;
+  p->blockLastMore = more;
+  p->blockNoBreak  = p->noBreak;
+  return strBufAppend(&p->blockText, s + p->blockIndent, n - p->blockIndent);
+}
+
+static int32_t yamlBlockStart(yamlParser_p p, const char *key, size_t keyLen,
+                              const char *s, size_t n, int32_t parentIndent) {
+  size_t i = 1;
+  p->blockChomp  = 0;
+  p->blockIndent = 0;
+  for (; (i < n) && (s[i] != ' ') && (s[i] != '\t'); i++) {
+    if ((s[i] == '-') || (s[i] == '+')) {
+      p->blockChomp = s[i];
+    } else if ((s[i] >= '1') && (s[i] <= '9')) {
+      p->blockIndent = parentIndent + (s[i] - '0');
+      if (parentIndent < 0) p->blockIndent = s[i] - '0';
+    } else {
+      return yamlError(p, p->lineNum, "bad block scalar header");
+    }
+  }
+  if (!yamlRestIsEmpty(s, i, n)) return yamlError(p, p->lineNum, "bad block scalar header");
+  p->block         = s[0];
+  p->blockParent   = parentIndent;
+  p->blockBlanks   = 0;
+  p->blockLastMore = 0;
+  p->blockNoBreak  = 0;
+  p->blockLine     = p->lineNum;
+  strBufClear(&p->blockKey);
+  strBufClear(&p->blockText);
+  if (strBufAppend(&p->blockKey, key, keyLen)) return ENOMEM;
+  return 0;
+}
+
+/* A value (after "key:" or "- ") that is on the same line */
+static int32_t yamlValue(yamlParser_p p, const char *key, size_t keyLen,
+                         const char *s, size_t n, int32_t parentIndent) {
+  size_t      pos = 0;
+  const char *msg;
+  int32_t     err;
+  if ((s[0] == '[') || (s[0] == '{')) {
+    return yamlFlowStart(p, key, keyLen, s, n, parentIndent);
+  }
+  if ((s[0] == '|') || (s[0] == '>')) {
+    return yamlBlockStart(p, key, keyLen, s, n, parentIndent);
+  }
+  err = yamlScalar(p, key, keyLen, s, n, &pos, "", &msg);
+  if (err) return err;
+  if (msg == NULL && !yamlRestIsEmpty(s, pos, n)) msg = "unexpected text after quoted string";
+  if (msg) return yamlError(p, p->lineNum, msg);
+  return 0;
+}
+
+/* Find the key of a block mapping entry "key: value" in s. On success
+ * the decoded key is in p->scratch and *valuePos indexes the value. */
+static int yamlFindKey(yamlParser_p p, const char *s, size_t n, size_t *valuePos, const char **msg) {
+  size_t i = 0, ke;
+  *msg = NULL;
+  if ((s[0] == '"') || (s[0] == '\'')) {
+    *msg = yamlQuoted(p, s, n, &i);
+    if (*msg) return 0;
+    while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+    if ((i >= n) || (s[i] != ':') || ((i+1 < n) && (s[i+1] != ' ') && (s[i+1] != '\t'))) return 0;
+  } else {
+    if ((s[0] == '[') || (s[0] == '{') || (s[0] == '|') || (s[0] == '>')) return 0;
+    for (i=0; i<n; i++) {
+      if ((s[i] == ':') && ((i+1 == n) || (s[i+1] == ' ') || (s[i+1] == '\t'))) break;
+      if ((s[i] == '#') && (i > 0) && ((s[i-1] == ' ') || (s[i-1] == '\t'))) return 0;
+    }
+    if (i == n) return 0;
+    ke = i;
+    while ((ke > 0) && (s[ke-1] == ' ' || s[ke-1] == '\t')) ke--;
+    if (ke == 0) return 0;
+    strBufClear(&p->scratch);
+    if (strBufAppend(&p->scratch, s, ke)) { *msg = "out of memory"; return 0; }
+  }
+  i++;
+  while ((i < n) && (s[i] == ' ' || s[i] == '\t')) i++;
+  *valuePos = i;
+  return 1;
+}
+
+static int32_t yamlMapEntry(yamlParser_p p, const char *s, size_t n, int32_t ind) {
+  size_t      vp;
+  const char *msg;
+  char       *key;
+  int32_t     err;
+  if (!yamlFindKey(p, s, n, &vp, &msg)) {
+    if (msg == NULL) msg = yamlUnsupported(s, n);
+    return yamlError(p, p->lineNum, msg ? msg : "expected \"key: value\"");
+  }
+  if (s[0] != '"' && s[0] != '\'' && (msg = yamlUnsupported(s, n)) != NULL) {
+    return yamlError(p, p->lineNum, msg);
+  }
+  if (yamlRestIsEmpty(s, vp, n)) {
+    p->pending        = 1;
+    p->pendingIndent  = ind;
+    p->pendingFromSeq = 0;
+    p->pendingLine    = p->lineNum;
+    strBufClear(&p->pendingKey);
+    return strBufAppend(&p->pendingKey, p->scratch.buf, p->scratch.len);
+  }
+  key = strdup(p->scratch.buf);
+  if (key == NULL) return ENOMEM;
+  err = yamlValue(p, key, strlen(key), s+vp, n-vp, ind);
+  free(key);
+  return err;
+}
+
+static int32_t yamlSeqItem(yamlParser_p p, const char *s, size_t n, int32_t ind) {
+  size_t      j = 1, vp;
+  const char *msg;
+  int32_t     err;
+  while ((j < n) && (s[j] == ' ')) j++;
+  if (yamlRestIsEmpty(s, j, n)) {
+    p->pending        = 1;
+    p->pendingIndent  = ind;
+    p->pendingFromSeq = 1;
+    p->pendingLine    = p->lineNum;
+    strBufClear(&p->pendingKey);
+    return 0;
+  }
+  s += j;
+  n -= j;
+  if (yamlIsSeqItem(s, n)) {
+    err = yamlPush(p, ind+j, 1, 0, "", 0);
+    if (err) return err;
+    return yamlSeqItem(p, s, n, ind+j);
+  }
+  if (yamlFindKey(p, s, n, &vp, &msg)) {
+    err = yamlPush(p, ind+j, 0, 0, "", 0);
+    if (err) return err;
+    return yamlMapEntry(p, s, n, ind+j);
+  }
+  if (msg) return yamlError(p, p->lineNum, msg);
+  return yamlValue(p, "", 0, s, n, ind);
+}
+
+/* A line with some content, s being its first non-space character */
+static int32_t yamlContent(yamlParser_p p, const char *s, size_t n, int32_t ind) {
+  int32_t     err;
+  int         isItem = yamlIsSeqItem(s, n);
+  size_t      vp;
+  const char *msg;
+
+  if (p->rootDone) return yamlError(p, p->lineNum, "unexpected content after document");
+
+  if (p->pending) {
+    p->pending = 0;
+    if ((ind > p->pendingIndent) ||
+        ((ind == p->pendingIndent) && isItem && !p->pendingFromSeq)) {
+      int32_t save = p->lineNum;
+      p->lineNum = p->pendingLine;
+      err = yamlPush(p, ind, isItem, (ind == p->pendingIndent), p->pendingKey.buf, p->pendingKey.len);
+      p->lineNum = save;
+      if (err) return err;
+    } else {
+      err = yamlEmit(p, yamlSCALAR, p->pendingLine, p->pendingKey.buf, p->pendingKey.len, "", 0, 0, 0);
+      if (err) return err;
+    }
+    yamlReleaseHeld(p);
+  }
+
+  while (p->depth > 0) {
+    yamlLevel_p top = &(p->stack[p->depth-1]);
+    if ((top->indent > ind) || ((top->indent == ind) && top->isSeq && top->sameIndent && !isItem)) {
+      err = yamlPop(p);
+      if (err) return err;
+    } else {
+      break;
+    }
+  }
+
+  if (p->depth == 0) {
+    if (p->started) return yamlError(p, p->lineNum, "unexpected content after document");
+    p->started = 1;
+    if (isItem) {
+      err = yamlPush(p, ind, 1, 0, "", 0);
+    } else if (yamlFindKey(p, s, n, &vp, &msg)) {
+      err = yamlPush(p, ind, 0, 0, "", 0);
+    } else {
+      if (msg) return yamlError(p, p->lineNum, msg);
+      p->rootDone = 1;
+      return yamlValue(p, "", 0, s, n, -1);
+    }
+    if (err) return err;
+  }
+
+  if (p->stack[p->depth-1].indent != ind) return yamlError(p, p->lineNum, "bad indentation");
+  if (p->stack[p->depth-1].isSeq) {
+    if (!isItem) return yamlError(p, p->lineNum, "expected a sequence item \"- \"");
+    return yamlSeqItem(p, s, n, ind);
+  } else {
+    if (isItem) return yamlError(p, p->lineNum, "sequence item where a mapping key was expected");
+    return yamlMapEntry(p, s, n, ind);
+  }
+}
+
+static int32_t yamlLine(yamlParser_p p, const char *s, size_t n) {
+  int32_t ind = 0, err, absorbed;
+  if ((n > 0) && (s[n-1] == '\r')) n--;
+  if (p->block) {
+    err = yamlBlockLine(p, s, n, &absorbed);
+    if (err || absorbed) return err;
+  }
+  while ((n > 0) && (s[n-1] == ' ' || s[n-1] == '\t')) n--;
+  if (p->flow) return yamlFlowContinue(p, s, n);
+  while ((ind < (int32_t)n) && (s[ind] == ' ')) ind++;
+  if (ind == (int32_t)n) return 0;
+  if (s[ind] == '#') {
+    size_t c = ind+1;
+    if ((c < n) && (s[c] == ' ')) c++;
+    if (p->pending && !p->holding) {
+      p->holding  = 1;
+      p->holdFrom = p->nEv;
+    }
+    return yamlEmit(p, yamlCOMMENT, p->lineNum, "", 0, s+c, n-c, 0, 0);
+  }
+  if (s[ind] == '\t') return yamlError(p, p->lineNum, "tabs are not allowed in indentation");
+  if ((ind == 0) && (n >= 3) && ((n == 3) || (s[3] == ' ') || (s[3] == '\t'))) {
+    if (0 == strncmp(s, "---", 3)) {
+      if (p->started) return yamlError(p, p->lineNum, "only one document per file is supported");
+      if (!yamlRestIsEmpty(s, 3, n)) return yamlError(p, p->lineNum, "content on the --- line is not supported");
+      return 0;
+    }
+    if (0 == strncmp(s, "...", 3)) {
+      p->finished = 1;
+      return 0;
+    }
+  }
+  if ((ind == 0) && (s[0] == '%')) return yamlError(p, p->lineNum, yamlUnsupported(s, n));
+  return yamlContent(p, s+ind, n-ind, ind);
+}
+
+/* End of input: close anything that's still open */
+static int32_t yamlEnd(yamlParser_p p) {
+  int32_t err = 0;
+  if (p->block) err = yamlBlockFinish(p);
+  if (!err && p->flow) {
+    p->flow = 0;
+    return yamlError(p, p->flowLine, "unterminated flow collection");
+  }
+  if (!err && p->pending) {
+    p->pending = 0;
+    err = yamlEmit(p, yamlSCALAR, p->pendingLine, p->pendingKey.buf, p->pendingKey.len, "", 0, 0, 0);
+    if (!err) yamlReleaseHeld(p);
+  }
+  while (!err && (p->depth > 0)) err = yamlPop(p);
+  p->finished = 1;
+  return err;
+}
+
+static void yamlParserFree(yamlParser_p p) {
+  if (p == NULL) return;
+  svlib_dpi_imported_lineReaderClose((void**)&(p->lr));
+  free(p->ev);
+  free(p->strs.buf);
+  free(p->stack);
+  free(p->pendingKey.buf);
+  free(p->blockKey.buf);
+  free(p->blockText.buf);
+  free(p->flowKey.buf);
+  free(p->flowText.buf);
+  free(p->scratch.buf);
+  p->sanity_check = NULL;
+  free(p);
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_yamlParserOpen(
+ *                            input  string  path,
+ *                            input  longint startOffset,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_yamlParserOpen(const char *path, int64_t startOffset, void **hnd) {
+  int32_t      err;
+  yamlParser_p p;
+  *hnd = NULL;
+  p = (yamlParser_p)calloc(1, sizeof(yamlParser_s));
+  if (p == NULL) return ENOMEM;
+  err = lineReaderMap(path, &(p->lr));
+  if (err) {
+    free(p);
+    return err;
+  }
+  if (startOffset > 0) {
+    p->lr->pos = ((uint64_t)startOffset < p->lr->size) ? (size_t)startOffset : p->lr->size;
+  }
+  p->sanity_check = p;
+  *hnd = (void*)p;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_yamlParserNext(
+ *                            inout  chandle hnd,
+ *                            output int     kinds[],
+ *                            output int     lineNums[],
+ *                            output string  keys[],
+ *                            output string  texts[],
+ *                            output int     isInt[],
+ *                            output longint intValues[],
+ *                            output int     n);
+ *----------------------------------------------------------------
+ * Deliver up to kinds.size() events. After a yamlERROR event no
+ * more events follow. The call that finds no more events returns
+ * n==0, releases the file and sets the handle to null.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_yamlParserNext(
+    void                  **hnd,
+    const svOpenArrayHandle kinds,
+    const svOpenArrayHandle lineNums,
+    const svOpenArrayHandle keys,
+    const svOpenArrayHandle texts,
+    const svOpenArrayHandle isInt,
+    const svOpenArrayHandle intValues,
+    int32_t                *n
+  ) {
+  yamlParser_p p = (yamlParser_p)(*hnd);
+  lineReader_p lr;
+  int32_t      i, size, err = 0;
+  size_t       base, k, ready;
+  const char  *line, *nl;
+  size_t       end;
+
+  *n = 0;
+  if (p == NULL) return 0;
+  if (p->sanity_check != p) return EINVAL;
+  lr = p->lr;
+
+  /* Discard events delivered last time, keeping the rest at the front.
+   * An event moved by yamlReleaseHeld may have its strings after those
+   * of the events that follow it, so find where the earliest one starts.
+   */
+  if (p->evHead > 0) {
+    if (p->evHead < p->nEv) {
+      base = p->ev[p->evHead].key;
+      for (k = p->evHead + 1; k < p->nEv; k++) {
+        if (p->ev[k].key < base) base = p->ev[k].key;
+      }
+      memmove(p->strs.buf, p->strs.buf + base, p->strs.len - base);
+      p->strs.len -= base;
+      for (k = p->evHead; k < p->nEv; k++) {
+        p->ev[k].key  -= base;
+        p->ev[k].text -= base;
+      }
+      memmove(p->ev, p->ev + p->evHead, (p->nEv - p->evHead) * sizeof(yamlEvent_s));
+      p->nEv -= p->evHead;
+      if (p->holding) p->holdFrom -= p->evHead;
+    } else {
+      p->nEv = 0;
+      strBufClear(&p->strs);
+    }
+    p->evHead = 0;
+  }
+
+  /* Held comments can't be delivered until the line before them is resolved */
+  size = svSize(kinds, 1);
+  while (!err && !p->finished && ((p->holding ? p->holdFrom : p->nEv) < (size_t)size)) {
+    if (lr->pos >= lr->size) {
+      err = yamlEnd(p);
+      break;
+    }
+    line = lr->base + lr->pos;
+    nl   = memchr(line, '\n', lr->size - lr->pos);
+    end  = (nl == NULL) ? lr->size : (size_t)(nl - lr->base);
+    p->lineNum++;
+    p->noBreak = (nl == NULL);
+    err = yamlLine(p, line, end - lr->pos);
+    lr->pos = (nl == NULL) ? lr->size : end + 1;
+    if (!err && p->finished && (p->depth > 0 || p->pending || p->block || p->flow)) {
+      /* "..." or an error: close up, but after an error emit nothing more */
+      if (p->nEv == 0 || p->ev[p->nEv-1].kind != yamlERROR) {
+        p->finished = 0;
+        err = yamlEnd(p);
+      }
+    }
+  }
+  if (err) return err;
+
+  if (p->nEv == 0) {
+    yamlParserFree(p);
+    *hnd = NULL;
+    return 0;
+  }
+
+  ready = p->holding ? p->holdFrom : p->nEv;
+  for (i=0; (i < size) && (p->evHead < ready); i++, p->evHead++) {
+    yamlEvent_p e = &(p->ev[p->evHead]);
+    *(int32_t*)svGetArrElemPtr1(kinds,     svLow(kinds, 1)     + i) = e->kind;
+    *(int32_t*)svGetArrElemPtr1(lineNums,  svLow(lineNums, 1)  + i) = e->line;
+    *(const char**)svGetArrElemPtr1(keys,  svLow(keys, 1)      + i) = p->strs.buf + e->key;
+    *(const char**)svGetArrElemPtr1(texts, svLow(texts, 1)     + i) = p->strs.buf + e->text;
+    *(int32_t*)svGetArrElemPtr1(isInt,     svLow(isInt, 1)     + i) = e->isInt;
+    *(int64_t*)svGetArrElemPtr1(intValues, svLow(intValues, 1) + i) = e->intValue;
+  }
+  *n = i;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_yamlParserClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_yamlParserClose(void **hnd) {
+  yamlParser_p p = (yamlParser_p)(*hnd);
+  if ((p != NULL) && (p->sanity_check == p)) {
+    yamlParserFree(p);
+  }
+  *hnd = NULL;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function string svlib_dpi_imported_yamlQuote(
+ *                            input  string s,
+ *                            input  int    isKey);
+ *----------------------------------------------------------------
+ * Return s unchanged if it can be written as a plain YAML scalar
+ * that the parser above reads back as the same string, otherwise
+ * double-quoted with escapes. Unless isKey, a string that would
+ * read back as an integer is quoted too. So are the words that
+ * other YAML readers take as booleans or null, in any case.
+ *----------------------------------------------------------------
+ */
+static SVLIB_THREAD_LOCAL strBuf_s yamlQuoteResult = {NULL, 0, 0};
+
+static const char *yamlReservedWords[] = {
+  "true", "false", "null", "~", "yes", "no", "on", "off", NULL
+};
+
+static int yamlIsReserved(const char *s) {
+  const char **w;
+  for (w = yamlReservedWords; *w != NULL; w++) {
+    if (!strcasecmp(s, *w)) return 1;
+  }
+  return 0;
+}
+
+extern const char* svlib_dpi_imported_yamlQuote(const char *s, int32_t isKey) {
+  size_t  n = strlen(s), i;
+  int     quote = 0;
+  int64_t v;
+  if (n == 0) {
+    quote = 1;
+  } else if (strchr("-?:,[]{}#&*!|>'\"%@`", s[0]) || s[0] == ' ' || s[n-1] == ' ' || s[n-1] == ':') {
+    quote = 1;
+  } else if (!isKey && yamlIsInt(s, n, &v)) {
+    quote = 1;
+  } else if ((n == 3) && (!strcmp(s, "---") || !strcmp(s, "..."))) {
+    quote = 1;
+  } else if (yamlIsReserved(s)) {
+    quote = 1;
+  } else {
+    for (i=0; i<n && !quote; i++) {
+      unsigned char c = s[i];
+      if ((c < 0x20) || (c == 0x7F)) quote = 1;
+      if ((c == ':') && ((s[i+1] == ' ') || (s[i+1] == '\t'))) quote = 1;
+      if ((c == '#') && ((s[i-1] == ' ') || (s[i-1] == '\t'))) quote = 1;
+    }
+  }
+  if (!quote) return s;
+  strBufClear(&yamlQuoteResult);
+  if (strBufAppend(&yamlQuoteResult, "\"", 1)) return s;
+  for (i=0; i<n; i++) {
+    unsigned char c = s[i];
+    char          esc[8];
+    const char   *e = esc;
+    switch (c) {
+      case '"':  e = "\\\""; break;
+      case '\\': e = "\\\\"; break;
+      case '\n': e = "\\n";  break;
+      case '\t': e = "\\t";  break;
+      case '\r': e = "\\r";  break;
+      default:
+        if ((c < 0x20) || (c == 0x7F)) {
+          sprintf(esc, "\\x%02x", c);
+        } else {
+          esc[0] = c;
+          esc[1] = 0;
+        }
+    }
+    if (strBufAppend(&yamlQuoteResult, e, strlen(e))) return s;
+  }
+  if (strBufAppend(&yamlQuoteResult, "\"", 1)) return s;
+  return yamlQuoteResult.buf;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Whole-file read and write helpers, retrying on EINTR and short counts.
+ */
+static int32_t readFully(int fd, strBuf_p sb, size_t sizeHint) {
+  ssize_t n;
+  if (strBufReserve(sb, sizeHint ? sizeHint : 4096)) return ENOMEM;
+  while (1) {
+    if (sb->len + 1 >= sb->size) {
+      if (strBufReserve(sb, sb->size)) return ENOMEM;
+    }
+    n = read(fd, sb->buf + sb->len, sb->size - sb->len - 1);
+    if (n == 0) break;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno;
+    }
+    sb->len += n;
+  }
+  sb->buf[sb->len] = 0;
+  return 0;
+}
+
+static int32_t writeFully(int fd, const char *s, size_t n) {
+  ssize_t done;
+  while (n > 0) {
+    done = write(fd, s, n);
+    if (done < 0) {
+      if (errno == EINTR) continue;
+      return errno;
+    }
+    s += done;
+    n -= done;
+  }
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_fileReadAll(
+ *                            input  string path,
+ *                            output string contents);
+ *----------------------------------------------------------------
+ * Read the whole of a file into a single string.
+ *----------------------------------------------------------------
+ */
+static SVLIB_THREAD_LOCAL strBuf_s readAllResult = {NULL, 0, 0};
+
+extern int32_t svlib_dpi_imported_fileReadAll(const char *path, const char **contents) {
+  int         fd;
+  int32_t     err;
+  struct stat st;
+  *contents = "";
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return errno;
+  if (fstat(fd, &st)) {
+    err = errno;
+  } else if (S_ISDIR(st.st_mode)) {
+    err = EISDIR;
+  } else {
+    strBufClear(&readAllResult);
+    /* st_size is only a hint: it's 0 for pipes and /proc files */
+    err = readFully(fd, &readAllResult, S_ISREG(st.st_mode) ? st.st_size : 0);
+  }
+  close(fd);
+  if (!err) *contents = readAllResult.buf;
+  return err;
+}
+
+/* Follow path through any chain of symbolic links to the name of the
+ * file that a write would actually reach, which need not exist yet.
+ * Only the final component is followed; a symlinked directory along
+ * the way is harmless because the temporary file and the rename both
+ * happen inside it. The result is malloc'd and must be freed.
+ */
+static int32_t fileResolveLinks(const char *path, char **target) {
+  char       *cur, *link, *next;
+  const char *slash;
+  struct stat st;
+  size_t      bufSize;
+  ssize_t     n;
+  int         hops;
+
+  *target = NULL;
+  cur = strdup(path);
+  if (cur == NULL) return ENOMEM;
+  for (hops = 0; ; hops++) {
+    if (lstat(cur, &st)) {
+      if (errno == ENOENT) break;
+      free(cur);
+      return errno;
+    }
+    if (!S_ISLNK(st.st_mode)) break;
+    if (hops >= 40) {
+      free(cur);
+      return ELOOP;
+    }
+    /* One byte more than the link needs, so that a link that has
+     * grown since lstat fills the buffer and can be told apart */
+    bufSize = st.st_size ? (size_t)st.st_size + 2 : PATH_MAX + 1;
+    link = malloc(bufSize);
+    if (link == NULL) {
+      free(cur);
+      return ENOMEM;
+    }
+    n = readlink(cur, link, bufSize - 1);
+    if (n < 0) {
+      free(link);
+      free(cur);
+      return errno;
+    }
+    if ((size_t)n == bufSize - 1) {
+      free(link);
+      if (st.st_size == 0) {
+        /* No size from lstat (as for /proc links), and PATH_MAX is full */
+        free(cur);
+        return ENAMETOOLONG;
+      }
+      continue;  /* replaced since lstat: look again, as one more hop */
+    }
+    link[n] = 0;
+    slash = strrchr(cur, '/');
+    if (link[0] == '/' || slash == NULL) {
+      next = link;
+    } else {
+      /* A relative link is relative to the directory holding it */
+      next = malloc((slash - cur) + 1 + n + 1);
+      if (next == NULL) {
+        free(link);
+        free(cur);
+        return ENOMEM;
+      }
+      memcpy(next, cur, (slash - cur) + 1);
+      strcpy(next + (slash - cur) + 1, link);
+      free(link);
+    }
+    free(cur);
+    cur = next;
+  }
+  *target = cur;
+  return 0;
+}
+
+/* Create a new, empty temporary file next to path, returning a
+ * descriptor open for writing and its malloc'd name. The file is
+ * created with mode 0666 so that the kernel applies the process's
+ * umask, exactly as it would for the real file; mkstemp would give
+ * 0600 and leave no thread-safe way to find out the umask.
+ */
+static pthread_mutex_t tempNameLock  = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long   tempNameCount = 0;
+
+static int32_t fileTempSibling(const char *path, int *fd, char **tmpName) {
+  char         *name;
+  unsigned long n;
+  int           tries;
+  int32_t       err = EEXIST;
+
+  name = malloc(strlen(path) + 64);
+  if (name == NULL) return ENOMEM;
+  for (tries = 0; tries < 100; tries++) {
+    pthread_mutex_lock(&tempNameLock);
+    n = tempNameCount++;
+    pthread_mutex_unlock(&tempNameLock);
+    sprintf(name, "%s.svlib%ld_%lu", path, (long)getpid(), n);
+    *fd = open(name, O_CREAT | O_EXCL | O_WRONLY, 0666);
+    if (*fd >= 0) {
+      *tmpName = name;
+      return 0;
+    }
+    if (errno != EEXIST) {
+      err = errno;
+      break;
+    }
+  }
+  free(name);
+  return err;
+}
+
+/* Replace (or, if append is set, extend) the contents of a file.
+ * A replacement is atomic: everything is written to a temporary file
+ * in the same directory, which is then renamed over the original, so
+ * any other process opening the file sees either the old or the new
+ * contents, never a mixture. An append writes only the new text, at
+ * the end of the existing file, so its cost does not grow with the
+ * size of the file. If path is a symbolic link the file it refers to
+ * is written and the link is left in place. An existing file keeps
+ * its permissions; a new file gets 0666 as modified by the process's
+ * umask, which is never changed here because it is process-wide.
+ */
+static int32_t fileReplace(const char *path, const char *contents, size_t len, int32_t append) {
+  char       *target = NULL, *tmpName = NULL;
+  int         fd, exists;
+  int32_t     err = 0;
+  struct stat st;
+
+  err = fileResolveLinks(path, &target);
+  if (err) return err;
+
+  if (0 == stat(target, &st)) {
+    if (S_ISDIR(st.st_mode)) {
+      free(target);
+      return EISDIR;
+    }
+    exists = 1;
+  } else if (errno == ENOENT) {
+    exists = 0;
+    append = 0;
+  } else {
+    err = errno;
+    free(target);
+    return err;
+  }
+
+  if (append) {
+    fd = open(target, O_WRONLY | O_APPEND);
+    free(target);
+    if (fd < 0) return errno;
+    err = writeFully(fd, contents, len);
+    if (close(fd) && !err) err = errno;
+    return err;
+  }
+
+  err = fileTempSibling(target, &fd, &tmpName);
+  if (err) {
+    free(target);
+    return err;
+  }
+
+  err = writeFully(fd, contents, len);
+  if (!err && exists && fchmod(fd, st.st_mode & 07777)) err = errno;
+  if (close(fd) && !err) err = errno;
+  if (!err && rename(tmpName, target)) err = errno;
+  if (err) unlink(tmpName);
+  free(tmpName);
+  free(target);
+  return err;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_fileWriteAll(
+ *                            input  string path,
+ *                            input  string contents,
+ *                            input  int    append);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_fileWriteAll(const char *path, const char *contents, int32_t append) {
+  return fileReplace(path, contents, strlen(contents), append);
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Asynchronous log sink, for LogSink. The caller appends each line to
+ * an in-memory buffer and never waits for the disk. A writer thread
+ * swaps that buffer for its own, empty one and writes it out whenever
+ * it holds SVLIB_LOG_SINK_BLOCK_SIZE bytes, when a flush is asked
+ * for, or after SVLIB_LOG_SINK_FLUSH_SECONDS without one. A line may
+ * be prefixed with a strftime timestamp, which is formatted again only
+ * when the second changes. An atexit handler flushes and closes every
+ * sink that is still open, so nothing is lost at $finish.
+ */
+#ifndef SVLIB_LOG_SINK_BLOCK_SIZE
+#define SVLIB_LOG_SINK_BLOCK_SIZE (1<<20)
+#endif
+#ifndef SVLIB_LOG_SINK_FLUSH_SECONDS
+#define SVLIB_LOG_SINK_FLUSH_SECONDS (1)
+#endif
+
+typedef struct logSink {
+  struct logSink  * sanity_check;
+  struct logSink  * next;          /* in the list of open sinks */
+  int               fd;
+  pthread_t         writer;
+  pthread_mutex_t   lock;
+  pthread_cond_t    wake;          /* for the writer: a full block, a flush or close */
+  pthread_cond_t    done;          /* for flushers: the writer has written a block */
+  strBuf_s          fill;          /* appended to by the caller */
+  strBuf_s          drain;         /* being written by the writer */
+  uint64_t          queued;        /* bytes appended so far */
+  uint64_t          written;       /* bytes written (or failed) so far */
+  uint64_t          flushTarget;   /* bytes that a flush is waiting for */
+  int64_t           lines;
+  int64_t           writes;
+  int64_t           maxPending;
+  int               closing;
+  int32_t           err;           /* first write error, or 0 */
+  char            * timeFormat;    /* NULL if lines have no timestamp */
+  int64_t           stampSecond;
+  strBuf_s          stamp;         /* timeFormat at stampSecond */
+} logSink_s, *logSink_p;
+
+static pthread_mutex_t logSinkListLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  logSinkOnce     = PTHREAD_ONCE_INIT;
+static logSink_p       logSinkList     = NULL;
+
+static void *logSinkWriter(void *arg) {
+  logSink_p ls = (logSink_p)arg;
+  pthread_mutex_lock(&ls->lock);
+  while (1) {
+    if (ls->fill.len == 0) {
+      if (ls->closing) break;
+      pthread_cond_wait(&ls->wake, &ls->lock);
+      continue;
+    }
+    if ((ls->fill.len < SVLIB_LOG_SINK_BLOCK_SIZE) && !ls->closing &&
+        (ls->flushTarget <= ls->written)) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += SVLIB_LOG_SINK_FLUSH_SECONDS;
+      if (pthread_cond_timedwait(&ls->wake, &ls->lock, &deadline) != ETIMEDOUT) continue;
+    }
+    {
+      strBuf_s full = ls->fill;
+      size_t   pos  = 0;
+      int32_t  err  = 0;
+      ls->fill  = ls->drain;
+      ls->drain = full;
+      strBufClear(&ls->fill);
+      pthread_mutex_unlock(&ls->lock);
+      while (pos < full.len) {
+        ssize_t n = write(ls->fd, full.buf + pos, full.len - pos);
+        if (n < 0) {
+          if (errno == EINTR) continue;
+          err = errno;
+          break;
+        }
+        pos += n;
+      }
+      pthread_mutex_lock(&ls->lock);
+      if (err && !ls->err) ls->err = err;
+      ls->written += full.len;
+      ls->writes++;
+      strBufClear(&ls->drain);
+      pthread_cond_broadcast(&ls->done);
+    }
+  }
+  pthread_mutex_unlock(&ls->lock);
+  return NULL;
+}
+
+/* Write out everything queued before the call; returns the first write error */
+static int32_t logSinkFlush(logSink_p ls) {
+  int32_t err;
+  pthread_mutex_lock(&ls->lock);
+  if (ls->flushTarget < ls->queued) ls->flushTarget = ls->queued;
+  pthread_cond_signal(&ls->wake);
+  while (ls->written < ls->queued) pthread_cond_wait(&ls->done, &ls->lock);
+  err = ls->err;
+  pthread_mutex_unlock(&ls->lock);
+  return err;
+}
+
+/* Write out everything, stop the writer and free the sink; the caller has unlisted it */
+static int32_t logSinkShut(logSink_p ls) {
+  int32_t err;
+  pthread_mutex_lock(&ls->lock);
+  ls->closing = 1;
+  pthread_cond_signal(&ls->wake);
+  pthread_mutex_unlock(&ls->lock);
+  pthread_join(ls->writer, NULL);
+  err = ls->err;
+  if (close(ls->fd) && !err) err = errno;
+  pthread_mutex_destroy(&ls->lock);
+  pthread_cond_destroy(&ls->wake);
+  pthread_cond_destroy(&ls->done);
+  free(ls->fill.buf);
+  free(ls->drain.buf);
+  free(ls->stamp.buf);
+  free(ls->timeFormat);
+  ls->sanity_check = NULL;
+  free(ls);
+  return err;
+}
+
+static void logSinkCloseAll(void) {
+  logSink_p ls;
+  pthread_mutex_lock(&logSinkListLock);
+  while ((ls = logSinkList) != NULL) {
+    logSinkList = ls->next;
+    (void) logSinkShut(ls);
+  }
+  pthread_mutex_unlock(&logSinkListLock);
+}
+
+static void logSinkRegisterAtExit(void) {
+  (void) atexit(logSinkCloseAll);
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_logSinkOpen(
+ *                            input  string  path,
+ *                            input  int     append,
+ *                            input  string  timeFormat,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ * Open (creating or truncating, or appending to) a file and start
+ * its writer thread. An empty timeFormat means no timestamps.
+ * Returns 0 or an errno value.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_logSinkOpen(
+    const char *path,
+    int32_t     append,
+    const char *timeFormat,
+    void      **hnd
+  ) {
+  logSink_p ls;
+  int32_t   err;
+  *hnd = NULL;
+  pthread_once(&logSinkOnce, logSinkRegisterAtExit);
+  ls = calloc(1, sizeof(logSink_s));
+  if (ls == NULL) return ENOMEM;
+  if (*timeFormat) {
+    ls->timeFormat = strdup(timeFormat);
+    if (ls->timeFormat == NULL) {
+      free(ls);
+      return ENOMEM;
+    }
+  }
+  ls->stampSecond = -1;
+  ls->fd = open(path, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0666);
+  if (ls->fd < 0) {
+    err = errno;
+    free(ls->timeFormat);
+    free(ls);
+    return err;
+  }
+  pthread_mutex_init(&ls->lock, NULL);
+  pthread_cond_init(&ls->wake, NULL);
+  pthread_cond_init(&ls->done, NULL);
+  err = pthread_create(&ls->writer, NULL, logSinkWriter, ls);
+  if (err) {
+    close(ls->fd);
+    pthread_mutex_destroy(&ls->lock);
+    pthread_cond_destroy(&ls->wake);
+    pthread_cond_destroy(&ls->done);
+    free(ls->timeFormat);
+    free(ls);
+    return err;
+  }
+  ls->sanity_check = ls;
+  pthread_mutex_lock(&logSinkListLock);
+  ls->next    = logSinkList;
+  logSinkList = ls;
+  pthread_mutex_unlock(&logSinkListLock);
+  *hnd = (void*)ls;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_logSinkWrite(
+ *                            input  chandle hnd,
+ *                            input  string  text);
+ *----------------------------------------------------------------
+ * Queue the timestamp (if any), text and a newline. Never waits
+ * for the writer. Returns ENOMEM, EBADF for a closed sink, or the
+ * first error that the writer has had, if any.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_logSinkWrite(void *hnd, const char *text) {
+  logSink_p ls = (logSink_p)hnd;
+  size_t    len = strlen(text), before;
+  int32_t   err = 0;
+  if ((ls == NULL) || (ls->sanity_check != ls)) return EBADF;
+  pthread_mutex_lock(&ls->lock);
+  before = ls->fill.len;
+  if (ls->timeFormat != NULL) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (now.tv_sec != ls->stampSecond) {
+      err = strftimeBuf(now.tv_sec, ls->timeFormat, &ls->stamp);
+      ls->stampSecond = err ? -1 : now.tv_sec;
+    }
+    if (!err) err = strBufAppend(&ls->fill, ls->stamp.buf, ls->stamp.len);
+  }
+  if (!err) err = strBufReserve(&ls->fill, len + 1);
+  if (!err) {
+    memcpy(ls->fill.buf + ls->fill.len, text, len);
+    ls->fill.len += len;
+    ls->fill.buf[ls->fill.len++] = '\n';
+    ls->fill.buf[ls->fill.len]   = 0;
+    ls->queued += ls->fill.len - before;
+    ls->lines++;
+    if ((int64_t)ls->fill.len > ls->maxPending) ls->maxPending = ls->fill.len;
+    if (ls->fill.len >= SVLIB_LOG_SINK_BLOCK_SIZE) pthread_cond_signal(&ls->wake);
+    err = ls->err;
+  } else {
+    ls->fill.len = before;
+  }
+  pthread_mutex_unlock(&ls->lock);
+  return err;
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_logSinkFlush(
+ *                            input  chandle hnd);
+ *----------------------------------------------------------------
+ * Wait until everything written so far has been passed to the OS.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_logSinkFlush(void *hnd) {
+  logSink_p ls = (logSink_p)hnd;
+  if ((ls == NULL) || (ls->sanity_check != ls)) return EBADF;
+  return logSinkFlush(ls);
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function void svlib_dpi_imported_logSinkStats(
+ *                            input  chandle hnd,
+ *                            output longint stats[logSinkARRAYSIZE]);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_logSinkStats(void *hnd, int64_t *stats) {
+  logSink_p ls = (logSink_p)hnd;
+  memset(stats, 0, logSinkARRAYSIZE * sizeof(int64_t));
+  if ((ls == NULL) || (ls->sanity_check != ls)) return;
+  pthread_mutex_lock(&ls->lock);
+  stats[logSinkLINES]       = ls->lines;
+  stats[logSinkBYTES]       = ls->queued;
+  stats[logSinkWRITTEN]     = ls->written;
+  stats[logSinkWRITES]      = ls->writes;
+  stats[logSinkMAX_PENDING] = ls->maxPending;
+  pthread_mutex_unlock(&ls->lock);
+}
+
+/*----------------------------------------------------------------
+ *   import "DPI-C" function int svlib_dpi_imported_logSinkClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ * Write out everything, stop the writer and close the file.
+ * Returns the first error that the writer had, if any.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_logSinkClose(void **hnd) {
+  logSink_p  ls = (logSink_p)(*hnd);
+  logSink_p *pp;
+  int32_t    err = EBADF;
+  *hnd = NULL;
+  if (ls == NULL) return 0;
+  pthread_mutex_lock(&logSinkListLock);
+  for (pp = &logSinkList; *pp != NULL; pp = &((*pp)->next)) {
+    if (*pp == ls) {
+      *pp = ls->next;
+      err = logSinkShut(ls);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&logSinkListLock);
+  return err;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Text sink, for cfgStreamWriter. Text is appended to a buffer on the
+ * C side, one piece per call, and taken back by SV either in blocks of
+ * about SVLIB_TEXT_SINK_BLOCK_SIZE bytes (to be written to a file) or
+ * all at once (to be returned as a string). Indentation is generated
+ * here so that SV never builds strings of spaces.
+ */
+#ifndef SVLIB_TEXT_SINK_BLOCK_SIZE
+#define SVLIB_TEXT_SINK_BLOCK_SIZE (65536)
+#endif
+
+static const char textSinkSpaces[] = "                                ";
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_textSinkOpen(
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_textSinkOpen(void **hnd) {
+  *hnd = calloc(1, sizeof(strBuf_s));
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_textSinkPut(
+ *                            input  chandle hnd,
+ *                            input  int     breakBefore,
+ *                            input  int     indent,
+ *                            input  string  text,
+ *                            output int     full);
+ *----------------------------------------------------------------
+ * Append a newline if breakBefore is set, then indent spaces, then
+ * the text. full is set when the sink holds at least a block of text.
+ * Returns ENOMEM if the text could not be stored.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_textSinkPut(
+    void       *hnd,
+    int32_t     breakBefore,
+    int32_t     indent,
+    const char *text,
+    int32_t    *full
+  ) {
+  strBuf_p sb = (strBuf_p)hnd;
+  size_t   len = strlen(text);
+  int32_t  n;
+  *full = 0;
+  if (sb == NULL) return ENOMEM;
+  if (indent < 0) indent = 0;
+  if (strBufReserve(sb, (breakBefore != 0) + indent + len)) return ENOMEM;
+  if (breakBefore) sb->buf[sb->len++] = '\n';
+  while (indent > 0) {
+    n = (indent < (int32_t)sizeof(textSinkSpaces) - 1) ? indent : (int32_t)sizeof(textSinkSpaces) - 1;
+    memcpy(sb->buf + sb->len, textSinkSpaces, n);
+    sb->len += n;
+    indent -= n;
+  }
+  memcpy(sb->buf + sb->len, text, len);
+  sb->len += len;
+  sb->buf[sb->len] = 0;
+  *full = (sb->len >= SVLIB_TEXT_SINK_BLOCK_SIZE);
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function string svlib_dpi_imported_textSinkTake(
+ *                            input  chandle hnd);
+ *----------------------------------------------------------------
+ * Everything put since the last take. The sink is emptied, but its
+ * buffer is kept so that it does not have to grow again.
+ *----------------------------------------------------------------
+ */
+extern const char* svlib_dpi_imported_textSinkTake(void *hnd) {
+  strBuf_p sb = (strBuf_p)hnd;
+  if ((sb == NULL) || (sb->len == 0)) return "";
+  sb->len = 0;
+  return sb->buf;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_textSinkClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_textSinkClose(void **hnd) {
+  strBuf_p sb = (strBuf_p)*hnd;
+  if (sb != NULL) {
+    free(sb->buf);
+    free(sb);
+  }
+  *hnd = NULL;
+}
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Split a cfgNode lookup path into its components, for cfgPath.
+ * This does the same job as running the RE
+ *   ^(\s*(\[\s*([[:digit:]]+)\s*\]|(\.)?\s*([^].[[:space:]]([^].[]*[^].[[:space:]]+)*))\s*)(.*)$
+ * once per component, but in a single pass. Each component is either
+ * an index [N] or a key, which may have a leading dot and may contain
+ * internal spaces; whitespace around components is ignored.
+ */
+#define cfgPathIsSpace(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\v' || (c)=='\f' || (c)=='\r')
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_cfgPathParse(
+ *                            input  string path,
+ *                            output int    kinds[],
+ *                            output int    textStart[],
+ *                            output int    textLen[],
+ *                            output int    ends[],
+ *                            output int    nComponents,
+ *                            output int    errorPos);
+ *----------------------------------------------------------------
+ * Each component's kind is a CFGPATH_COMPONENT_ENUM, its text is
+ * path[textStart +: textLen] (the digits of an index, or the key),
+ * and ends is the position just after it and any whitespace that
+ * follows it. The arrays must have at least strlen(path) elements.
+ * If a component cannot be parsed, errorPos is where it starts;
+ * otherwise errorPos is -1. An empty path is an error at 0.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_cfgPathParse(
+    const char             *path,
+    const svOpenArrayHandle kinds,
+    const svOpenArrayHandle textStart,
+    const svOpenArrayHandle textLen,
+    const svOpenArrayHandle ends,
+    int32_t                *nComponents,
+    int32_t                *errorPos
+  ) {
+  int32_t size = svSize(kinds, 1);
+  int32_t n = 0;
+  int32_t pos = 0, p, start, last, kind;
+
+  *errorPos = -1;
+  while ((path[pos] != 0) && (n < size)) {
+    p = pos;
+    while (cfgPathIsSpace(path[p])) p++;
+    if (path[p] == '[') {
+      p++;
+      while (cfgPathIsSpace(path[p])) p++;
+      start = p;
+      while ((path[p] >= '0') && (path[p] <= '9')) p++;
+      last = p;
+      while (cfgPathIsSpace(path[p])) p++;
+      if ((last == start) || (path[p] != ']')) break;
+      p++;
+      kind = cfgpathINDEX;
+    } else {
+      kind = cfgpathKEY;
+      if (path[p] == '.') {
+        kind = cfgpathDOTKEY;
+        p++;
+        while (cfgPathIsSpace(path[p])) p++;
+      }
+      start = p;
+      last  = p;
+      if ((path[p] == 0) || (path[p] == ']') || (path[p] == '[') || (path[p] == '.')) break;
+      /* key runs up to the next ] . [ or end, less trailing spaces */
+      while ((path[p] != 0) && (path[p] != ']') && (path[p] != '[') && (path[p] != '.')) {
+        if (!cfgPathIsSpace(path[p])) last = p + 1;
+        p++;
+      }
+      p = last;
+    }
+    while (cfgPathIsSpace(path[p])) p++;
+    *(int32_t*)svGetArrElemPtr1(kinds,     svLow(kinds, 1)     + n) = kind;
+    *(int32_t*)svGetArrElemPtr1(textStart, svLow(textStart, 1) + n) = start;
+    *(int32_t*)svGetArrElemPtr1(textLen,   svLow(textLen, 1)   + n) = last - start;
+    *(int32_t*)svGetArrElemPtr1(ends,      svLow(ends, 1)      + n) = p;
+    n++;
+    pos = p;
+  }
+  if ((path[pos] != 0) || (n == 0)) *errorPos = pos;
+  *nComponents = n;
+}
+
+
+/*--------------------------------------------------------------------------
+ * FOR INTERNAL USE BY SVLIB ONLY:
+ *--------------------------------------------------------------------------
+ * Binary snapshots of a cfgNode DOM, for cfgFileBinary.
+ *
+ * A snapshot is a header followed by one record per node in pre-order,
+ * so that each collection's record is followed by those of its children.
+ * A node's comments are records of their own, just before the node.
+ * Every string is stored as a 32-bit length, the characters and a
+ * terminating null, so that the reader can give SV pointers straight
+ * into the mapped file. Numbers are in native byte order: a snapshot is
+ * a cache for the machine that wrote it, not an interchange format.
+ *
+ *   header: "SVLIBCFG" version(u32) nRecords(u64)
+ *           sourceSize(i64) sourceMtimeNs(i64) sourceInode(i64) stampTimeNs(i64)
+ *           sourcePath(str) sourceKind(str)
+ *   record: kind(u32) nChildren(u32) aval(i64) bval(i64)
+ *           name(str) hint(str) text(str)
+ *
+ * The source fields identify the text file that the DOM was parsed
+ * from, if any, so that a cached snapshot can be checked for staleness.
+ * Times are in nanoseconds since the epoch. File systems stamp files
+ * from a clock that can lag the real-time clock by a tick, and some
+ * keep only whole seconds (the nanoseconds then read as 0), so a source
+ * modified just before the stamp was taken could be changed again with
+ * no visible change of modification time. A snapshot is trusted only if
+ * its stamp is at least CFGBIN_MTIME_SLACK_NS after the source's
+ * modification time, or a whole second for a whole-second time.
+ */
+#define CFGBIN_MAGIC         "SVLIBCFG"
+#define CFGBIN_VERSION       (2)
+#define CFGBIN_NRECORDS_AT   (12)
+#define CFGBIN_RECORD_FIXED  (24)
+#define CFGBIN_MTIME_SLACK_NS (50000000LL)
+
+/* Modification time of a stat result, in nanoseconds */
+static int64_t cfgBinMtimeNs(const struct stat *st) {
+  return (int64_t)st->st_mtime * 1000000000 + statNsec(st, m);
+}
+
+typedef struct cfgBin {
+  struct cfgBin * sanity_check;
+  strBuf_s        out;        /* writer: the snapshot being built      */
+  uint64_t        nRecords;
+  lineReader_p    map;        /* reader: the mapped snapshot           */
+  size_t          pos;
+  uint64_t        remaining;
+} cfgBin_s, *cfgBin_p;
+
+static void cfgBinFree(cfgBin_p cb) {
+  if (cb == NULL) return;
+  free(cb->out.buf);
+  svlib_dpi_imported_lineReaderClose((void**)&(cb->map));
+  cb->sanity_check = NULL;
+  free(cb);
+}
+
+static int32_t cfgBinPutStr(strBuf_p sb, const char *s) {
+  uint32_t n = strlen(s);
+  if (strBufAppend(sb, (const char*)&n, sizeof(n))) return ENOMEM;
+  if (strBufAppend(sb, s, n)) return ENOMEM;
+  return strBufAppend(sb, "", 1) ? ENOMEM : 0;
+}
+
+/* Read a fixed-size field, or a string, checking it lies within the file */
+static int32_t cfgBinGet(cfgBin_p cb, void *field, size_t n) {
+  if (cb->map->size - cb->pos < n) return EINVAL;
+  memcpy(field, cb->map->base + cb->pos, n);
+  cb->pos += n;
+  return 0;
+}
+
+static int32_t cfgBinGetStr(cfgBin_p cb, const char **s) {
+  uint32_t n;
+  if (cfgBinGet(cb, &n, sizeof(n))) return EINVAL;
+  if ((cb->map->size - cb->pos <= n) || (cb->map->base[cb->pos + n] != 0)) return EINVAL;
+  *s = cb->map->base + cb->pos;
+  cb->pos += n + 1;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_cfgBinWriterOpen(
+ *                            input  string  sourcePath,
+ *                            input  string  sourceKind,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ * Start building a snapshot. If sourcePath is not empty, the
+ * source file's size and modification time are recorded now,
+ * before it is parsed, so that a change made while parsing makes
+ * the snapshot stale rather than silently out of date.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_cfgBinWriterOpen(const char *sourcePath, const char *sourceKind, void **hnd) {
+  cfgBin_p    cb;
+  struct stat st;
+  uint32_t    version = CFGBIN_VERSION;
+  uint64_t    zero    = 0;
+  int64_t     stamp[4] = {0, 0, 0, 0};
+  struct timespec now;
+  *hnd = NULL;
+  if (*sourcePath) {
+    if (stat(sourcePath, &st)) return errno;
+    (void) clock_gettime(CLOCK_REALTIME, &now);
+    stamp[0] = st.st_size;
+    stamp[1] = cfgBinMtimeNs(&st);
+    stamp[2] = st.st_ino;
+    stamp[3] = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+  }
+  cb = (cfgBin_p)calloc(1, sizeof(cfgBin_s));
+  if (cb == NULL) return ENOMEM;
+  if (strBufAppend(&cb->out, CFGBIN_MAGIC, 8) ||
+      strBufAppend(&cb->out, (const char*)&version, sizeof(version)) ||
+      strBufAppend(&cb->out, (const char*)&zero, sizeof(zero)) ||
+      strBufAppend(&cb->out, (const char*)stamp, sizeof(stamp)) ||
+      cfgBinPutStr(&cb->out, sourcePath) ||
+      cfgBinPutStr(&cb->out, sourceKind)) {
+    cfgBinFree(cb);
+    return ENOMEM;
+  }
+  cb->sanity_check = cb;
+  *hnd = (void*)cb;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_cfgBinWrite(
+ *                            input  chandle hnd,
+ *                            input  int     kind,
+ *                            input  int     nChildren,
+ *                            input  longint aval,
+ *                            input  longint bval,
+ *                            input  string  name,
+ *                            input  string  hint,
+ *                            input  string  text);
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_cfgBinWrite(
+    void       *hnd,
+    int32_t     kind,
+    int32_t     nChildren,
+    int64_t     aval,
+    int64_t     bval,
+    const char *name,
+    const char *hint,
+    const char *text
+  ) {
+  cfgBin_p cb = (cfgBin_p)hnd;
+  uint32_t fixed[2];
+  int64_t  value[2];
+  if ((cb == NULL) || (cb->sanity_check != cb) || (cb->map != NULL)) return EINVAL;
+  fixed[0] = kind;
+  fixed[1] = nChildren;
+  value[0] = aval;
+  value[1] = bval;
+  if (strBufAppend(&cb->out, (const char*)fixed, sizeof(fixed)) ||
+      strBufAppend(&cb->out, (const char*)value, sizeof(value)) ||
+      cfgBinPutStr(&cb->out, name) ||
+      cfgBinPutStr(&cb->out, hint) ||
+      cfgBinPutStr(&cb->out, text)) {
+    return ENOMEM;
+  }
+  cb->nRecords++;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_cfgBinWriterFinish(
+ *                            inout  chandle hnd,
+ *                            input  string  path);
+ *----------------------------------------------------------------
+ * Write the snapshot to path, atomically replacing any existing
+ * file, and release the writer. If path is empty the snapshot is
+ * simply discarded.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_cfgBinWriterFinish(void **hnd, const char *path) {
+  cfgBin_p cb = (cfgBin_p)(*hnd);
+  int32_t  err = 0;
+  if ((cb == NULL) || (cb->sanity_check != cb) || (cb->map != NULL)) return EINVAL;
+  if (*path) {
+    memcpy(cb->out.buf + CFGBIN_NRECORDS_AT, &(cb->nRecords), sizeof(cb->nRecords));
+    err = fileReplace(path, cb->out.buf, cb->out.len, 0);
+  }
+  cfgBinFree(cb);
+  *hnd = NULL;
+  return err;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_cfgBinReaderOpen(
+ *                            input  string  path,
+ *                            input  string  sourcePath,
+ *                            input  string  sourceKind,
+ *                            output chandle hnd);
+ *----------------------------------------------------------------
+ * Map a snapshot and check its header. Returns EINVAL if the file
+ * is not a snapshot that this version can read. If sourcePath is
+ * not empty, the snapshot must have been made from that file, by a
+ * reader of kind sourceKind, and the file's size, modification time
+ * and inode must not have changed since; otherwise returns ESTALE.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_cfgBinReaderOpen(
+    const char *path,
+    const char *sourcePath,
+    const char *sourceKind,
+    void      **hnd
+  ) {
+  cfgBin_p    cb;
+  int32_t     err;
+  char        magic[8];
+  uint32_t    version;
+  int64_t     stamp[4];
+  const char *snapSource, *snapKind;
+  struct stat st;
+
+  *hnd = NULL;
+  cb = (cfgBin_p)calloc(1, sizeof(cfgBin_s));
+  if (cb == NULL) return ENOMEM;
+  err = lineReaderMap(path, &(cb->map));
+  if (!err) {
+    if (cfgBinGet(cb, magic, sizeof(magic)) || memcmp(magic, CFGBIN_MAGIC, sizeof(magic)) ||
+        cfgBinGet(cb, &version, sizeof(version)) || (version != CFGBIN_VERSION) ||
+        cfgBinGet(cb, &(cb->remaining), sizeof(cb->remaining)) ||
+        cfgBinGet(cb, stamp, sizeof(stamp)) ||
+        cfgBinGetStr(cb, &snapSource) ||
+        cfgBinGetStr(cb, &snapKind)) {
+      err = EINVAL;
+    }
+  }
+  if (!err && *sourcePath) {
+    if (strcmp(sourcePath, snapSource) || strcmp(sourceKind, snapKind)) {
+      err = ESTALE;
+    } else if (stat(sourcePath, &st)) {
+      err = errno;
+    } else if ((stamp[0] != st.st_size) ||
+               (stamp[1] != cfgBinMtimeNs(&st)) ||
+               (stamp[2] != (int64_t)st.st_ino) ||
+               (stamp[3] - stamp[1] < ((stamp[1] % 1000000000) ? CFGBIN_MTIME_SLACK_NS : 1000000000))) {
+      err = ESTALE;
+    }
+  }
+  if (err) {
+    cfgBinFree(cb);
+    return err;
+  }
+  cb->sanity_check = cb;
+  *hnd = (void*)cb;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function int svlib_dpi_imported_cfgBinReaderNext(
+ *                            inout  chandle hnd,
+ *                            output int     kinds[],
+ *                            output int     nChildren[],
+ *                            output longint avals[],
+ *                            output longint bvals[],
+ *                            output string  names[],
+ *                            output string  hints[],
+ *                            output string  texts[],
+ *                            output int     n);
+ *----------------------------------------------------------------
+ * Deliver up to kinds.size() records. The strings point into the
+ * mapped file and stay valid until the reader is closed. The call
+ * that finds no more records returns n==0, unmaps the file and
+ * sets the handle to null. A truncated or corrupt file gives EINVAL.
+ *----------------------------------------------------------------
+ */
+extern int32_t svlib_dpi_imported_cfgBinReaderNext(
+    void                  **hnd,
+    const svOpenArrayHandle kinds,
+    const svOpenArrayHandle nChildren,
+    const svOpenArrayHandle avals,
+    const svOpenArrayHandle bvals,
+    const svOpenArrayHandle names,
+    const svOpenArrayHandle hints,
+    const svOpenArrayHandle texts,
+    int32_t                *n
+  ) {
+  cfgBin_p    cb = (cfgBin_p)(*hnd);
+  int32_t     i, size;
+  uint32_t    fixed[2];
+  int64_t     value[2];
+  const char *name, *hint, *text;
+
+  *n = 0;
+  if (cb == NULL) return 0;
+  if ((cb->sanity_check != cb) || (cb->map == NULL)) return EINVAL;
+
+  if (cb->remaining == 0) {
+    cfgBinFree(cb);
+    *hnd = NULL;
+    return 0;
+  }
+
+  size = svSize(kinds, 1);
+  for (i=0; (i < size) && (cb->remaining > 0); i++, cb->remaining--) {
+    if (cfgBinGet(cb, fixed, sizeof(fixed)) ||
+        cfgBinGet(cb, value, sizeof(value)) ||
+        cfgBinGetStr(cb, &name) ||
+        cfgBinGetStr(cb, &hint) ||
+        cfgBinGetStr(cb, &text) ||
+        (fixed[0] > cfgbinCOMMENT)) {
+      return EINVAL;
+    }
+    *(int32_t*)svGetArrElemPtr1(kinds,       svLow(kinds, 1)     + i) = fixed[0];
+    *(int32_t*)svGetArrElemPtr1(nChildren,   svLow(nChildren, 1) + i) = fixed[1];
+    *(int64_t*)svGetArrElemPtr1(avals,       svLow(avals, 1)     + i) = value[0];
+    *(int64_t*)svGetArrElemPtr1(bvals,       svLow(bvals, 1)     + i) = value[1];
+    *(const char**)svGetArrElemPtr1(names,   svLow(names, 1)     + i) = name;
+    *(const char**)svGetArrElemPtr1(hints,   svLow(hints, 1)     + i) = hint;
+    *(const char**)svGetArrElemPtr1(texts,   svLow(texts, 1)     + i) = text;
+  }
+  *n = i;
+  return 0;
+}
+
+/*----------------------------------------------------------------
+ * import "DPI-C" function void svlib_dpi_imported_cfgBinClose(
+ *                            inout  chandle hnd);
+ *----------------------------------------------------------------
+ * Release a reader or writer early.
+ *----------------------------------------------------------------
+ */
+extern void svlib_dpi_imported_cfgBinClose(void **hnd) {
+  cfgBin_p cb = (cfgBin_p)(*hnd);
+  if ((cb != NULL) && (cb->sanity_check == cb)) {
+    cfgBinFree(cb);
+  }
+  *hnd = NULL;
+}
+
+
 /*----------------------------------------------------------------
  * import "DPI-C" function int svlib_dpi_imported_access(
  *              input string path, input int mode, output int ok);
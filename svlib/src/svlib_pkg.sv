@@ -32,6 +32,7 @@ package svlib_pkg;
   import svlib_private_base_pkg::*;
 
   `include "svlib_pkg_Error.svh"
+  `include "svlib_pkg_Pool.svh"
   `include "svlib_pkg_Str.svh"
   `include "svlib_pkg_Regex.svh"
   `include "svlib_pkg_Enum.svh"
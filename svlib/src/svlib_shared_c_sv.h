@@ -29,6 +29,8 @@
 
 /*  STAT_INDEX_ENUM
  *  Represents the stat struct returned by the fileStat DPI call.
+ *  The *NS elements are the nanoseconds part of each timestamp,
+ *  or 0 if the platform does not provide it.
  */
 typedef enum {
   statMTIME,
@@ -38,6 +40,11 @@ typedef enum {
   statGID,
   statSIZE,
   statMODE,
+  statMTIMENS,
+  statATIMENS,
+  statCTIMENS,
+  statINODE,
+  statDEVICE,
   statARRAYSIZE /* must always be the last one */
 } STAT_INDEX_ENUM;
 
@@ -69,6 +76,90 @@ typedef enum {
   regexNOLINE  = 2
 } REGEX_OPTIONS_ENUM;
 
+/*  INI_RECORD_ENUM
+ *  Kinds of record returned by the INI file lexer used by
+ *  cfgFileINI::deserialize.
+ */
+typedef enum {
+  iniCOMMENT,     /* text1 is the comment text                */
+  iniSECTION,     /* text1 is the section name                */
+  iniKEYVAL,      /* text1 is the key, text2 the value        */
+  iniBADSYNTAX    /* text1 is the offending (trimmed) line    */
+} INI_RECORD_ENUM;
+
+/*  YAML_EVENT_ENUM
+ *  Kinds of event returned by the YAML parser used by
+ *  cfgFileYAML::deserialize.
+ */
+typedef enum {
+  yamlSCALAR,     /* key (if in a map), text, and integer value if isInt */
+  yamlMAPSTART,   /* key (if in a map)                                   */
+  yamlMAPEND,
+  yamlSEQSTART,   /* key (if in a map)                                   */
+  yamlSEQEND,
+  yamlCOMMENT,    /* text is a full-line comment                         */
+  yamlERROR       /* text describes the problem                          */
+} YAML_EVENT_ENUM;
+
+/*  CFGBIN_RECORD_ENUM
+ *  Kinds of record in a cfgFileBinary snapshot. A comment record
+ *  belongs to the node record that follows it, or to the root node
+ *  if no node record follows it.
+ */
+typedef enum {
+  cfgbinMAP,      /* nChildren records for its members follow  */
+  cfgbinSEQUENCE, /* nChildren records for its items follow    */
+  cfgbinSTRING,   /* text is the value                         */
+  cfgbinINT,      /* aval/bval are the 4-state value           */
+  cfgbinCOMMENT   /* text is the comment                       */
+} CFGBIN_RECORD_ENUM;
+
+/*  CFGPATH_COMPONENT_ENUM
+ *  Kinds of component in a cfgPath.
+ */
+typedef enum {
+  cfgpathINDEX,   /* [N]   */
+  cfgpathKEY,     /* key   */
+  cfgpathDOTKEY   /* .key  */
+} CFGPATH_COMPONENT_ENUM;
+
+/*  CLOCK_KIND_ENUM
+ *  Clocks that can be read by the clockTime DPI call, and used
+ *  by profiling regions.
+ */
+typedef enum {
+  clockREALTIME,  /* wall-clock time, can be adjusted          */
+  clockMONOTONIC, /* never goes backwards                      */
+  clockTHREADCPU, /* CPU time used by the calling thread       */
+  clockPROCESSCPU /* CPU time used by the whole process        */
+} CLOCK_KIND_ENUM;
+
+/*  PROF_STAT_ENUM
+ *  Represents the statistics of a profiling region returned
+ *  by the profStats DPI call. Times are in nanoseconds.
+ */
+typedef enum {
+  profCOUNT,      /* number of samples                         */
+  profTOTAL,      /* sum of all samples                        */
+  profMIN,        /* shortest sample, 0 if none                */
+  profMAX,        /* longest sample                            */
+  profOPEN,       /* starts not yet matched by a stop          */
+  profARRAYSIZE   /* must always be the last one               */
+} PROF_STAT_ENUM;
+
+/*  LOG_SINK_STAT_ENUM
+ *  Represents the statistics of an asynchronous log sink
+ *  returned by the logSinkStats DPI call.
+ */
+typedef enum {
+  logSinkLINES,       /* lines written by the user                 */
+  logSinkBYTES,       /* bytes queued, including timestamps        */
+  logSinkWRITTEN,     /* bytes passed to the OS by the writer      */
+  logSinkWRITES,      /* blocks written by the writer              */
+  logSinkMAX_PENDING, /* most bytes ever waiting to be written     */
+  logSinkARRAYSIZE    /* must always be the last one               */
+} LOG_SINK_STAT_ENUM;
+
 /*  ACCESS_MODE_ENUM
  *  Bitmap to represent the various kinds of access (RWX) that
  *  can be made to a file, for access() checking.
@@ -1,3 +1,3 @@
 ../src/svlib_pkg.sv
 ../src/dpi/svlib_dpi.c
--sverilog -LDFLAGS -lrt
+-sverilog -LDFLAGS "-lrt -lpthread -lz"
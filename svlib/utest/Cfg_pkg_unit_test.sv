@@ -0,0 +1,950 @@
+`include "svunit_defines.svh"
+`include "svlib_macros.svh"
+
+module Cfg_pkg_test_unit_test;
+  import svunit_pkg::svunit_testcase;
+  import svlib_pkg::*;
+
+  string name = "Cfg_pkg_test_ut";
+  svunit_testcase svunit_ut;
+
+
+  //===================================
+  // This is the UUT that we're
+  // running the Unit Tests on
+  //===================================
+
+  cfgFileINI    my_INI;
+  cfgFileYAML   my_YAML;
+  cfgFileBinary my_BIN;
+
+  // Write ~text~ to ~fname~ and deserialize it with ~file~,
+  // returning the root node and the file object's error
+  function automatic cfgNode readText(cfgFile file, string fname, string text,
+                                      output cfgError_enum err);
+    cfgNode root;
+    file_writeAll(fname, text);
+    err = file.openR(fname);
+    if (err != CFG_OK) return null;
+    root = file.deserialize();
+    err = file.getLastError();
+    void'(file.close());
+    return root;
+  endfunction
+
+  // The text of the scalar at ~path~ below ~root~, or "<missing>"
+  function automatic string scalarAt(cfgNode root, string path);
+    cfgNodeScalar ns;
+    if (root == null) return "<missing>";
+    if (!$cast(ns, root.lookup(path)) || (ns == null)) return "<missing>";
+    return ns.value.str();
+  endfunction
+
+  // Is the node at ~path~ below ~root~ an integer scalar?
+  function automatic bit isIntAt(cfgNode root, string path);
+    cfgNodeScalar ns;
+    cfgScalarInt  csi;
+    if (root == null) return 0;
+    if (!$cast(ns, root.lookup(path)) || (ns == null)) return 0;
+    return $cast(csi, ns.value);
+  endfunction
+
+
+  //===================================
+  // Build
+  //===================================
+  function void build();
+    svunit_ut = new(name);
+  endfunction
+
+
+  //===================================
+  // Setup for running the Unit Tests
+  //===================================
+  task setup();
+    svunit_ut.setup();
+    /* Place Setup Code Here */
+    my_INI  = cfgFileINI::create();
+    my_YAML = cfgFileYAML::create();
+    my_BIN  = cfgFileBinary::create();
+  endtask
+
+
+  //===================================
+  // Here we deconstruct anything we
+  // need after running the Unit Tests
+  //===================================
+  task teardown();
+    svunit_ut.teardown();
+    /* Place Teardown Code Here */
+
+  endtask
+
+
+  //===================================
+  // All tests are defined between the
+  // SVUNIT_TESTS_BEGIN/END macros
+  //
+  // Each individual test must be
+  // defined between `SVTEST(_NAME_)
+  // `SVTEST_END
+  //
+  // i.e.
+  //   `SVTEST(mytest)
+  //     <test code>
+  //   `SVTEST_END
+  //===================================
+  `SVUNIT_TESTS_BEGIN
+
+  `SVTEST(cfgFileINI_sections_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    cfgNodeMap    nm;
+
+    root = readText(my_INI, "cfgFileINI_sections_check.ini", {
+      "top = 1\n",
+      "[sec_a]\n",
+      "x = hello\n",
+      "  y: 'quoted value'  \n",
+      "\n",
+      "[ sec_b ]\n",
+      "z=\"two words\"\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS($cast(nm, root))
+    `FAIL_UNLESS_EQUAL(nm.value.size(), 3)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "top"),       "1")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec_a.x"),   "hello")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec_a.y"),   "quoted value")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec_b.z"),   "two words")
+    `FAIL_UNLESS_EQUAL(root.lookup("sec_a").kind(), NODE_MAP)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileINI_comments_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    cfgNode       nd;
+
+    root = readText(my_INI, "cfgFileINI_comments_check.ini", {
+      "; about the file\n",
+      "#about the section\n",
+      "[s]\n",
+      "# about k\n",
+      "  ;  indented\n",
+      "k=v\n",
+      "j=w\n",
+      "# trailing\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    // Comments annotate the next section or key
+    nd = root.lookup("s");
+    `FAIL_UNLESS_EQUAL(nd.comments.size(), 2)
+    `FAIL_UNLESS_STR_EQUAL(nd.comments[0], "about the file")
+    `FAIL_UNLESS_STR_EQUAL(nd.comments[1], "about the section")
+    nd = root.lookup("s.k");
+    `FAIL_UNLESS_EQUAL(nd.comments.size(), 2)
+    `FAIL_UNLESS_STR_EQUAL(nd.comments[0], "about k")
+    `FAIL_UNLESS_STR_EQUAL(nd.comments[1], " indented")
+    `FAIL_UNLESS_EQUAL(root.lookup("s.j").comments.size(), 0)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileINI_continuation_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+
+    // INI files have no continuation lines: an indented line is
+    // read on its own, as a key if it has one...
+    root = readText(my_INI, "cfgFileINI_continuation_check.ini", {
+      "[s]\n",
+      "k = first\n",
+      "    j = second\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "s.k"), "first")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "s.j"), "second")
+
+    // ...and as bad syntax otherwise; a trailing backslash
+    // does not join lines either
+    my_INI = cfgFileINI::create();
+    root = readText(my_INI, "cfgFileINI_continuation_check.ini", {
+      "[s]\n",
+      "k = first \\\n",
+      "    and more\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_INI_BAD_SYNTAX)
+    `FAIL_UNLESS(root == null)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileINI_bad_lines_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    string        bad[$] = {"no separator", "[unclosed", "[two words]", "k =", "k = unbalanced'"};
+
+    foreach (bad[i]) begin
+      my_INI = cfgFileINI::create();
+      root = readText(my_INI, "cfgFileINI_bad_lines_check.ini",
+                      {"[s]\n", "k=v\n", bad[i], "\n"}, err);
+      `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_INI_BAD_SYNTAX)
+      `FAIL_UNLESS(root == null)
+    end
+
+    // Not opened for reading
+    my_INI = cfgFileINI::create();
+    `FAIL_UNLESS(my_INI.deserialize() == null)
+    `FAIL_UNLESS_EQUAL(my_INI.getLastError(), CFG_DESERIALIZE_FILE_NOT_READ)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileINI_many_keys_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    string        text;
+
+    // More records than one lexer batch
+    for (int i=0; i<3*`SVLIB_CFG_LEXER_BATCH_SIZE; i++) begin
+      if (i % 100 == 0) text = {text, $sformatf("[sec%0d]\n", i/100)};
+      text = {text, $sformatf("key%0d = %0d\n", i, i)};
+    end
+    root = readText(my_INI, "cfgFileINI_many_keys_check.ini", text, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec0.key0"), "0")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec2.key257"), "257")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, $sformatf("sec%0d.key%0d",
+                             (3*`SVLIB_CFG_LEXER_BATCH_SIZE-1)/100, 3*`SVLIB_CFG_LEXER_BATCH_SIZE-1)),
+                           $sformatf("%0d", 3*`SVLIB_CFG_LEXER_BATCH_SIZE-1))
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileINI_serialize_check)
+
+    string        fname = "cfgFileINI_serialize_check.ini";
+    cfgNodeMap    nm, sec;
+    cfgNodeScalar ns;
+
+    nm = cfgNodeMap::create("root");
+    nm.comments.push_back("top");
+    nm.addNode(cfgScalarInt::createNode("n", 3));
+    nm.addNode(cfgScalarString::createNode("name", "two words"));
+    sec = cfgNodeMap::create("sec");
+    sec.comments.push_back("about sec");
+    nm.addNode(sec);
+    sec.addNode(cfgScalarString::createNode("k", "v"));
+    ns = cfgScalarInt::createNode("ks", 1);
+    ns.comments.push_back("about ks");
+    sec.addNode(ns);
+
+    `FAIL_UNLESS_EQUAL(my_INI.openW(fname), CFG_OK)
+    `FAIL_UNLESS_EQUAL(my_INI.serialize(nm), CFG_OK)
+    void'(my_INI.close());
+    // Byte for byte what writing each line with $fdisplay gave
+    `FAIL_UNLESS_STR_EQUAL(file_readAll(fname), {
+      "\n",
+      "# top\n",
+      "n=3\n",
+      "name=\"two words\"\n",
+      "\n",
+      "\n",
+      "# about sec\n",
+      "[sec]\n",
+      "k=v\n",
+      "\n",
+      "# about ks\n",
+      "ks=1\n",
+      "\n"})
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_block_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+
+    root = readText(my_YAML, "cfgFileYAML_block_check.yaml", {
+      "---\n",
+      "name: block test\n",
+      "count: 0x1F\n",
+      "nested:\n",
+      "  inner: -3\n",
+      "  empty:\n",
+      "list:\n",
+      "- first\n",
+      "- key: value\n",
+      "  other: 2\n",
+      "- - deep\n",
+      "  - deeper\n",
+      "indented:\n",
+      "    - a\n",
+      "    - b\n",
+      "text: |\n",
+      "  line one\n",
+      "  line two\n",
+      "folded: >-\n",
+      "  one\n",
+      "  two\n",
+      "...\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS_EQUAL(root.kind(), NODE_MAP)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "name"),             "block test")
+    `FAIL_UNLESS(isIntAt(root, "count"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "count"),            "31")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "nested.inner"),     "-3")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "nested.empty"),     "")
+    `FAIL_UNLESS_EQUAL(root.lookup("list").kind(), NODE_SEQUENCE)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "list[0]"),          "first")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "list[1].key"),      "value")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "list[1].other"),    "2")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "list[2][1]"),       "deeper")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "indented[1]"),      "b")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "text"),             "line one\nline two\n")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "folded"),           "one two")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_flow_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+
+    root = readText(my_YAML, "cfgFileYAML_flow_check.yaml", {
+      "map: {a: 1, b: [x, y], c: {}}\n",
+      "seq: [1, {k: v}, [], plain text]\n",
+      "multi: [one,\n",
+      "  two, # a comment inside\n",
+      "  three]\n",
+      "novalue: {a, b: }\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "map.a"),      "1")
+    `FAIL_UNLESS(isIntAt(root, "map.a"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "map.b[1]"),   "y")
+    `FAIL_UNLESS_EQUAL(root.lookup("map.c").kind(), NODE_MAP)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "seq[1].k"),   "v")
+    `FAIL_UNLESS_EQUAL(root.lookup("seq[2]").kind(), NODE_SEQUENCE)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "seq[3]"),     "plain text")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "multi[2]"),   "three")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "novalue.a"),  "")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "novalue.b"),  "")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_quoting_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+
+    root = readText(my_YAML, "cfgFileYAML_quoting_check.yaml", {
+      "single: 'it''s # not a comment'\n",
+      "double: \"tab\\there\\x41\\u00e9\"\n",
+      "number: \"12\"\n",
+      "plain: a#b  # a comment\n",
+      "'quoted key': 1\n",
+      "flow: {\"a,b\": 'c: d'}\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "single"),     "it's # not a comment")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "double"),     "tab\there\x41\xc3\xa9")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "number"),     "12")
+    `FAIL_IF(isIntAt(root, "number"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "plain"),      "a#b")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "quoted key"), "1")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "flow.a,b"),   "c: d")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_empty_key_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    cfgNodeMap    nm;
+    cfgNodeScalar ns;
+
+    // An empty quoted key, in a flow map and in a block map
+    root = readText(my_YAML, "cfgFileYAML_empty_key_check.yaml", {
+      "flow: {\"\": 1, b: 2}\n",
+      "block:\n",
+      "  \"\": 3\n",
+      "'': 4\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS($cast(nm, root))
+    `FAIL_UNLESS(nm.value.exists(""))
+    `FAIL_UNLESS($cast(ns, nm.value[""]))
+    `FAIL_UNLESS_STR_EQUAL(ns.value.str(), "4")
+    `FAIL_UNLESS($cast(nm, root.lookup("flow")))
+    `FAIL_UNLESS(nm.value.exists(""))
+    `FAIL_UNLESS($cast(nm, root.lookup("block")))
+    `FAIL_UNLESS_EQUAL(nm.value.size(), 1)
+    `FAIL_UNLESS($cast(ns, nm.value[""]))
+    `FAIL_UNLESS_STR_EQUAL(ns.value.str(), "3")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_comments_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+
+    root = readText(my_YAML, "cfgFileYAML_comments_check.yaml", {
+      "# about the file\n",
+      "a:\n",
+      "  # about b\n",
+      "  b: 1\n",
+      "  c:\n",
+      "  # about d\n",
+      "  d:\n",
+      "    # about d[0]\n",
+      "    - x\n",
+      "# about e\n",
+      "e: 2\n"}, err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS_EQUAL(root.comments.size(), 1)
+    `FAIL_UNLESS_STR_EQUAL(root.comments[0], "about the file")
+    `FAIL_UNLESS_EQUAL(root.lookup("a").comments.size(), 0)
+    `FAIL_UNLESS_EQUAL(root.lookup("a.b").comments.size(), 1)
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("a.b").comments[0], "about b")
+    `FAIL_UNLESS_EQUAL(root.lookup("a.c").comments.size(), 0)
+    `FAIL_UNLESS_EQUAL(root.lookup("a.d").comments.size(), 1)
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("a.d").comments[0], "about d")
+    `FAIL_UNLESS_EQUAL(root.lookup("a.d[0]").comments.size(), 1)
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("a.d[0]").comments[0], "about d[0]")
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("e").comments[0], "about e")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_bad_syntax_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    string        bad[$] = {
+      "a: &anchor 1\n",
+      "a: *alias\n",
+      "a: !tag 1\n",
+      "a:\n\tb: 1\n",
+      "a: [1, 2\n",
+      "a: 'unterminated\n",
+      "a: 1\n- b\n",
+      "a: 1\n  b: 2\n",
+      "a: 1\n---\nb: 2\n",
+      "just a scalar\nmore\n"};
+
+    foreach (bad[i]) begin
+      my_YAML = cfgFileYAML::create();
+      root = readText(my_YAML, "cfgFileYAML_bad_syntax_check.yaml", bad[i], err);
+      `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_YAML_BAD_SYNTAX)
+      `FAIL_UNLESS(root == null)
+    end
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_empty_file_check)
+
+    cfgError_enum err;
+    cfgNode       root;
+    cfgNodeMap    nm;
+
+    root = readText(my_YAML, "cfgFileYAML_empty_file_check.yaml", "", err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS($cast(nm, root))
+    `FAIL_IF(nm == null)
+    `FAIL_UNLESS_EQUAL(nm.value.size(), 0)
+
+    my_YAML = cfgFileYAML::create();
+    root = readText(my_YAML, "cfgFileYAML_empty_file_check.yaml", "# nothing here\n\n", err);
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_UNLESS($cast(nm, root))
+    `FAIL_IF(nm == null)
+    `FAIL_UNLESS_EQUAL(nm.value.size(), 0)
+    `FAIL_UNLESS_EQUAL(nm.comments.size(), 1)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileYAML_round_trip_check)
+
+    string          fname = "cfgFileYAML_round_trip_check.yaml";
+    Str             text;
+    cfgNodeMap      nm, inner;
+    cfgNodeSequence nq;
+    cfgNode         root;
+    cfgNodeScalar   ns;
+    cfgError_enum   err;
+
+    nm = cfgNodeMap::create("root");
+    nm.addNode(cfgScalarInt::createNode("int", -42));
+    nm.addNode(cfgScalarString::createNode("looks_int", "42"));
+    nm.addNode(cfgScalarString::createNode("tricky", "- a: b # c"));
+    nm.addNode(cfgScalarString::createNode("empty", ""));
+    nm.addNode(cfgScalarString::createNode("", "empty key"));
+    nm.addNode(cfgScalarString::createNode("bool", "True"));
+    nm.addNode(cfgScalarString::createNode("off", "~"));
+    inner = cfgNodeMap::create("inner");
+    inner.comments.push_back("about inner");
+    nm.addNode(inner);
+    ns = cfgScalarString::createNode("key", "line\nbreak");
+    ns.comments.push_back("about inner.key");
+    inner.addNode(ns);
+    inner.addNode(cfgNodeMap::create("none"));
+    nq = cfgNodeSequence::create("seq");
+    nm.addNode(nq);
+    nq.addNode(cfgScalarInt::createNode("", 1));
+    ns = cfgScalarString::createNode("", "two");
+    ns.comments.push_back("about seq[1]");
+    nq.addNode(ns);
+    nq.addNode(cfgNodeSequence::create(""));
+
+    `FAIL_UNLESS_EQUAL(my_YAML.openW(fname), CFG_OK)
+    `FAIL_UNLESS_EQUAL(my_YAML.serialize(nm), CFG_OK)
+    void'(my_YAML.close());
+    // Words other readers take as booleans or null are quoted, even as keys
+    text = Str::create(file_readAll(fname));
+    `FAIL_UNLESS(text.first("bool: \"True\"\n") >= 0)
+    `FAIL_UNLESS(text.first("\"off\": \"~\"\n") >= 0)
+
+    `FAIL_UNLESS_EQUAL(my_YAML.openR(fname), CFG_OK)
+    root = my_YAML.deserialize();
+    err = my_YAML.getLastError();
+    void'(my_YAML.close());
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS_STR_EQUAL(root.sformat(), nm.sformat())
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "bool"), "True")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "off"),  "~")
+    `FAIL_UNLESS(isIntAt(root, "int"))
+    `FAIL_IF(isIntAt(root, "looks_int"))
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("inner").comments[0],     "about inner")
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("inner.key").comments[0], "about inner.key")
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("seq[1]").comments[0],    "about seq[1]")
+    `FAIL_UNLESS_EQUAL(root.lookup("seq[2]").kind(), NODE_SEQUENCE)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileBinary_round_trip_check)
+
+    string          fname = "cfgFileBinary_round_trip_check.svlibcfg";
+    cfgNodeMap      nm;
+    cfgNodeSequence nq;
+    cfgNode         root;
+    cfgNodeScalar   ns;
+    cfgScalarInt    csi;
+    cfgError_enum   err;
+
+    nm = cfgNodeMap::create("root");
+    nm.comments.push_back("about root");
+    nm.addNode(cfgScalarInt::createNode("int", -42));
+    nm.addNode(cfgScalarInt::createNode("fourState", 64'sb10xz_10xz));
+    nm.addNode(cfgScalarString::createNode("str", "line\nbreak"));
+    nm.addNode(cfgScalarString::createNode("", "empty key"));
+    ns = cfgScalarInt::createNode("hex", 'hBEEF);
+    ns.serializationHint = "hex";
+    ns.comments.push_back("about hex");
+    ns.comments.push_back("");
+    nm.addNode(ns);
+    nq = cfgNodeSequence::create("seq");
+    nm.addNode(nq);
+    nq.addNode(cfgScalarString::createNode("", "one"));
+    nq.addNode(cfgNodeMap::create(""));
+    nq.addNode(cfgNodeSequence::create(""));
+
+    `FAIL_UNLESS_EQUAL(my_BIN.openW(fname), CFG_OK)
+    `FAIL_UNLESS_EQUAL(my_BIN.serialize(nm), CFG_OK)
+    void'(my_BIN.close());
+
+    `FAIL_UNLESS_EQUAL(my_BIN.openR(fname), CFG_OK)
+    root = my_BIN.deserialize();
+    err = my_BIN.getLastError();
+    void'(my_BIN.close());
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS_STR_EQUAL(root.sformat(), nm.sformat())
+    `FAIL_UNLESS_EQUAL(root.comments.size(), 1)
+    `FAIL_UNLESS_STR_EQUAL(root.comments[0], "about root")
+    `FAIL_UNLESS($cast(ns, root.lookup("fourState")))
+    `FAIL_UNLESS($cast(csi, ns.value))
+    `FAIL_UNLESS(csi.value === 64'sb10xz_10xz)
+    `FAIL_UNLESS(isIntAt(root, "int"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "str"), "line\nbreak")
+    `FAIL_UNLESS($cast(nm, root))
+    `FAIL_UNLESS($cast(ns, nm.value[""]))
+    `FAIL_UNLESS_STR_EQUAL(ns.value.str(), "empty key")
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("hex").serializationHint, "hex")
+    `FAIL_UNLESS_EQUAL(root.lookup("hex").comments.size(), 2)
+    `FAIL_UNLESS_STR_EQUAL(root.lookup("hex").comments[0], "about hex")
+    `FAIL_UNLESS_EQUAL(root.lookup("seq[1]").kind(), NODE_MAP)
+    `FAIL_UNLESS_EQUAL(root.lookup("seq[2]").kind(), NODE_SEQUENCE)
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileBinary_trailing_comments_check)
+
+    // The writer never puts comments after the last node, but a
+    // snapshot that has them must not lose them
+    string  fname = "cfgFileBinary_trailing_comments_check.svlibcfg";
+    chandle hnd;
+    cfgNode root;
+
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWriterOpen("", "", hnd), 0)
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWrite(
+                         hnd, svlib_private_base_pkg::cfgbinCOMMENT, 0, 0, 0, "", "", "leading"), 0)
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWrite(
+                         hnd, svlib_private_base_pkg::cfgbinMAP, 1, 0, 0, "root", "", ""), 0)
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWrite(
+                         hnd, svlib_private_base_pkg::cfgbinSTRING, 0, 0, 0, "a", "", "x"), 0)
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWrite(
+                         hnd, svlib_private_base_pkg::cfgbinCOMMENT, 0, 0, 0, "", "", "trailing"), 0)
+    `FAIL_UNLESS_EQUAL(svlib_private_base_pkg::svlib_dpi_imported_cfgBinWriterFinish(hnd, fname), 0)
+
+    `FAIL_UNLESS_EQUAL(my_BIN.openR(fname), CFG_OK)
+    root = my_BIN.deserialize();
+    void'(my_BIN.close());
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "a"), "x")
+    `FAIL_UNLESS_EQUAL(root.lookup("a").comments.size(), 0)
+    `FAIL_UNLESS_EQUAL(root.comments.size(), 2)
+    `FAIL_UNLESS_STR_EQUAL(root.comments[0], "leading")
+    `FAIL_UNLESS_STR_EQUAL(root.comments[1], "trailing")
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileBinary_bad_format_check)
+
+    string        fname = "cfgFileBinary_bad_format_check.svlibcfg";
+    string        bad   = "cfgFileBinary_bad_format_check_bad.svlibcfg";
+    cfgNodeMap    nm;
+    cfgNode       root;
+    cfgError_enum err;
+    int           fd;
+    longint       cuts[2];
+
+    nm = cfgNodeMap::create("root");
+    for (int i=0; i<10; i++) nm.addNode(cfgScalarInt::createNode($sformatf("k%0d", i), i));
+    `FAIL_UNLESS_EQUAL(my_BIN.openW(fname), CFG_OK)
+    `FAIL_UNLESS_EQUAL(my_BIN.serialize(nm), CFG_OK)
+    void'(my_BIN.close());
+
+    // Not a snapshot at all
+    file_writeAll(bad, "[section]\nkey = value\n");
+    `FAIL_UNLESS_EQUAL(my_BIN.openR(bad), CFG_OK)
+    root = my_BIN.deserialize();
+    err = my_BIN.getLastError();
+    void'(my_BIN.close());
+    `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_BINARY_BAD_FORMAT)
+    `FAIL_UNLESS(root == null)
+
+    // Right magic number, wrong version
+    `FAIL_UNLESS_EQUAL($system({"cp ", fname, " ", bad}), 0)
+    fd = $fopen(bad, "r+b");
+    `FAIL_IF(fd == 0)
+    void'($fseek(fd, 8, 0));
+    $fwrite(fd, "%c", 8'd99);
+    $fclose(fd);
+    my_BIN = cfgFileBinary::create();
+    `FAIL_UNLESS_EQUAL(my_BIN.openR(bad), CFG_OK)
+    root = my_BIN.deserialize();
+    err = my_BIN.getLastError();
+    void'(my_BIN.close());
+    `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_BINARY_BAD_FORMAT)
+    `FAIL_UNLESS(root == null)
+
+    // Truncated in the header, and in the last record
+    cuts = '{20, file_size(fname) - 3};
+    foreach (cuts[i]) begin
+      `FAIL_UNLESS_EQUAL($system($sformatf("head -c %0d %s > %s", cuts[i], fname, bad)), 0)
+      my_BIN = cfgFileBinary::create();
+      `FAIL_UNLESS_EQUAL(my_BIN.openR(bad), CFG_OK)
+      root = my_BIN.deserialize();
+      err = my_BIN.getLastError();
+      void'(my_BIN.close());
+      `FAIL_UNLESS_EQUAL(err, CFG_DESERIALIZE_BINARY_BAD_FORMAT)
+      `FAIL_UNLESS(root == null)
+    end
+
+  `SVTEST_END
+
+  `SVTEST(cfgFileBinary_cached_check)
+
+    string         src  = "cfgFileBinary_cached_check.ini";
+    string         snap = "cfgFileBinary_cached_check.ini.svlibcfg";
+    string         mark = "touch -d @1000000000 cfgFileBinary_cached_check.ini.svlibcfg";
+    sys_fileStat_s srcStat, newStat;
+    cfgNode        root;
+    longint        sec;
+
+    // A source last modified well before the snapshot is taken
+    file_writeAll(src, "a = 1\n");
+    sec = sys_dayTime() - 100;
+    `FAIL_UNLESS_EQUAL($system($sformatf("touch -d @%0d.123456789 %s", sec, src)), 0)
+    `FAIL_UNLESS_EQUAL($system({"rm -f ", snap}), 0)
+    srcStat = sys_fileStat(src);
+
+    // No snapshot yet: the source is parsed and a snapshot written.
+    // The snapshot's own modification time is not checked, so it
+    // serves to mark the snapshot and see whether it is rewritten.
+    `FAIL_UNLESS_EQUAL(my_INI.openR(src), CFG_OK)
+    root = cfgFileBinary::deserializeCached(my_INI);
+    void'(my_INI.close());
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "a"), "1")
+    `FAIL_UNLESS(file_accessible(snap))
+    `FAIL_UNLESS_EQUAL($system(mark), 0)
+
+    // Unchanged source: the snapshot is used, not rewritten
+    my_INI = cfgFileINI::create();
+    `FAIL_UNLESS_EQUAL(my_INI.openR(src), CFG_OK)
+    root = cfgFileBinary::deserializeCached(my_INI);
+    void'(my_INI.close());
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "a"), "1")
+    `FAIL_UNLESS_EQUAL(sys_fileStat(snap).mtime, 1000000000)
+
+    // Same size, same inode (the shell rewrites the file in place) and
+    // same whole-second modification time; only the nanoseconds show
+    // that the source has changed
+    `FAIL_UNLESS_EQUAL($system({"printf 'a = 2\\n' > ", src}), 0)
+    `FAIL_UNLESS_EQUAL($system($sformatf("touch -d @%0d.987654321 %s", sec, src)), 0)
+    newStat = sys_fileStat(src);
+    `FAIL_UNLESS_EQUAL(newStat.size,  srcStat.size)
+    `FAIL_UNLESS_EQUAL(newStat.mtime, srcStat.mtime)
+    my_INI = cfgFileINI::create();
+    `FAIL_UNLESS_EQUAL(my_INI.openR(src), CFG_OK)
+    root = cfgFileBinary::deserializeCached(my_INI);
+    void'(my_INI.close());
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "a"), "2")
+    `FAIL_IF(sys_fileStat(snap).mtime == 1000000000)
+
+    // and the rewritten snapshot is used from now on
+    `FAIL_UNLESS_EQUAL($system(mark), 0)
+    my_INI = cfgFileINI::create();
+    `FAIL_UNLESS_EQUAL(my_INI.openR(src), CFG_OK)
+    root = cfgFileBinary::deserializeCached(my_INI);
+    void'(my_INI.close());
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "a"), "2")
+    `FAIL_UNLESS_EQUAL(sys_fileStat(snap).mtime, 1000000000)
+
+  `SVTEST_END
+
+  `SVTEST(cfgPath_parse_check)
+
+    cfgPath cp = cfgPath::create("a.b[3].c");
+    `FAIL_UNLESS_STR_EQUAL(cp.get(), "a.b[3].c")
+    `FAIL_UNLESS_EQUAL(cp.size(), 4)
+    `FAIL_UNLESS(cp.isValid())
+
+    cp.set(" a . b [ 3 ] ");
+    `FAIL_UNLESS_EQUAL(cp.size(), 3)
+    `FAIL_UNLESS(cp.isValid())
+
+    cp.set("a..b");
+    `FAIL_UNLESS_EQUAL(cp.size(), 1)
+    `FAIL_IF(cp.isValid())
+
+    cp.set("a[x]");
+    `FAIL_IF(cp.isValid())
+
+    cp.set("");
+    `FAIL_UNLESS_EQUAL(cp.size(), 0)
+
+  `SVTEST_END
+
+  `SVTEST(cfgNode_lookupPath_check)
+
+    cfgNodeMap      nm1, nm2, inner;
+    cfgNodeSequence nq;
+    cfgNode         nd;
+    cfgPath         cp;
+
+    nm1 = cfgNodeMap::create("root1");
+    inner = cfgNodeMap::create("a");
+    nm1.addNode(inner);
+    nq = cfgNodeSequence::create("b");
+    inner.addNode(nq);
+    for (int i=0; i<4; i++) nq.addNode(cfgScalarInt::createNode("", i));
+    nm2 = cfgNodeMap::create("root2");
+    inner = cfgNodeMap::create("a");
+    nm2.addNode(inner);
+    nq = cfgNodeSequence::create("b");
+    inner.addNode(nq);
+    for (int i=0; i<4; i++) nq.addNode(cfgScalarInt::createNode("", 10+i));
+
+    // One parsed path, used in two DOMs, agrees with lookup(string)
+    cp = cfgPath::create("a.b[3]");
+    nd = nm1.lookupPath(cp);
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_OK)
+    `FAIL_UNLESS(nd == nm1.lookup("a.b[3]"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(nm1, "a.b[3]"), "3")
+    nd = nm2.lookupPath(cp);
+    `FAIL_UNLESS(nd == nm2.lookup("a.b[3]"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(nm2, "a.b[3]"), "13")
+    `FAIL_UNLESS_STR_EQUAL(nm2.getFoundPath(), "a.b[3]")
+
+    // Errors, with the path as far as it was followed
+    cp.set("a.b[4]");
+    `FAIL_UNLESS(nm1.lookupPath(cp) == null)
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_LOOKUP_NOT_FOUND)
+    `FAIL_UNLESS_STR_EQUAL(nm1.getFoundPath(), "a.b")
+    cp.set("a[0]");
+    `FAIL_UNLESS(nm1.lookupPath(cp) == null)
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_LOOKUP_NOT_SEQUENCE)
+    cp.set("a.b.c");
+    `FAIL_UNLESS(nm1.lookupPath(cp) == null)
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_LOOKUP_NOT_MAP)
+    cp.set("a..b");
+    `FAIL_UNLESS(nm1.lookupPath(cp) == null)
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_LOOKUP_BAD_SYNTAX)
+    `FAIL_UNLESS(nm1.lookup("a..b") == null)
+    `FAIL_UNLESS_EQUAL(nm1.getLastError(), CFG_LOOKUP_BAD_SYNTAX)
+
+  `SVTEST_END
+
+  `SVTEST(cfgNode_lookupMemo_check)
+
+    // A remembered lookup is only forgotten by addNode, so changing a
+    // map directly shows whether the memo was still in use
+    cfgNodeMap    nm1, nm2, inner1, inner2;
+    cfgNodeScalar old1, new1, old2, new2;
+
+    nm1    = cfgNodeMap::create("root1");
+    inner1 = cfgNodeMap::create("a");
+    nm1.addNode(inner1);
+    old1 = cfgScalarInt::createNode("b", 1);
+    new1 = cfgScalarInt::createNode("b", 2);
+    inner1.addNode(old1);
+    nm2    = cfgNodeMap::create("root2");
+    inner2 = cfgNodeMap::create("a");
+    nm2.addNode(inner2);
+    old2 = cfgScalarInt::createNode("b", 3);
+    new2 = cfgScalarInt::createNode("b", 4);
+    inner2.addNode(old2);
+
+    nm1.enableLookupMemo();
+    inner2.enableLookupMemo();
+    `FAIL_UNLESS(nm1.lookup("a.b") == old1)
+    `FAIL_UNLESS(inner2.lookup("b") == old2)
+    inner1.value["b"] = new1;
+    inner2.value["b"] = new2;
+    `FAIL_UNLESS(nm1.lookup("a.b") == old1)
+    `FAIL_UNLESS(inner2.lookup("b") == old2)
+
+    // addNode in another DOM leaves the memo alone
+    nm2.addNode(cfgScalarInt::createNode("c", 0));
+    `FAIL_UNLESS(nm1.lookup("a.b") == old1)
+
+    // addNode anywhere in the same DOM forgets it, whether below the
+    // remembering node (nm1) or in another branch (inner2)
+    inner1.addNode(cfgScalarInt::createNode("c", 0));
+    `FAIL_UNLESS(nm1.lookup("a.b") == new1)
+    `FAIL_UNLESS(nm1.getFoundNode() == new1)
+    `FAIL_UNLESS(inner2.lookup("b") == new2)
+
+    // A remembered result is used again until the next change
+    inner1.value["b"] = old1;
+    `FAIL_UNLESS(nm1.lookup("a.b") == new1)
+    inner1.addNode(cfgScalarInt::createNode("d", 0));
+    `FAIL_UNLESS(nm1.lookup("a.b") == old1)
+
+    // Adding a DOM into another one forgets the memo of its old root
+    nm2.enableLookupMemo();
+    `FAIL_UNLESS(nm2.lookup("a.b") == new2)
+    inner2.value["b"] = old2;
+    nm1.addNode(nm2);
+    `FAIL_UNLESS(nm2.lookup("a.b") == old2)
+    `FAIL_UNLESS(nm1.lookup("root2.a.b") == old2)
+
+    // Without the memo every lookup walks the DOM
+    nm1.enableLookupMemo(0);
+    inner1.value["b"] = new1;
+    `FAIL_UNLESS(nm1.lookup("a.b") == new1)
+
+  `SVTEST_END
+
+  `SVTEST(cfgNode_sformat_check)
+
+    cfgNodeMap      nm, inner;
+    cfgNodeSequence nq;
+
+    nm = cfgNodeMap::create("root");
+    nm.addNode(cfgScalarInt::createNode("a", 1));
+    nq = cfgNodeSequence::create("b");
+    nm.addNode(nq);
+    nq.addNode(cfgScalarString::createNode("", "x"));
+    inner = cfgNodeMap::create("");
+    nq.addNode(inner);
+    inner.addNode(cfgScalarString::createNode("k", "v"));
+    nm.addNode(cfgNodeMap::create("c"));
+    nm.addNode(cfgNodeSequence::create("d"));
+
+    // The text that concatenating each level's strings gave
+    `FAIL_UNLESS_STR_EQUAL(nm.sformat(), {
+      "a : \n",
+      " 1\n",
+      "b : \n",
+      " - \n",
+      "  x\n",
+      " - \n",
+      "  k : \n",
+      "   v\n",
+      "c : \n",
+      "\n",
+      "d : \n"})
+    `FAIL_UNLESS_STR_EQUAL(nq.sformat(2), {
+      "  - \n",
+      "   x\n",
+      "  - \n",
+      "   k : \n",
+      "    v"})
+    `FAIL_UNLESS_STR_EQUAL(inner.sformat(), "k : \n v")
+
+  `SVTEST_END
+
+  `SVTEST(cfgStreamWriter_large_check)
+
+    string          fname = "cfgStreamWriter_large_check.txt";
+    string          iniName = "cfgStreamWriter_large_check.ini";
+    string          text;
+    cfgNodeMap      nm, sec;
+    cfgNode         root;
+    cfgStreamWriter w;
+    cfgError_enum   err;
+    int             fd;
+
+    // Well over SVLIB_TEXT_SINK_BLOCK_SIZE (64KB) of text, so that the
+    // writer flushes blocks to the file before the end
+    nm = cfgNodeMap::create("root");
+    for (int i=0; i<200; i++) begin
+      sec = cfgNodeMap::create($sformatf("sec%0d", i));
+      nm.addNode(sec);
+      for (int k=0; k<20; k++)
+        sec.addNode(cfgScalarString::createNode($sformatf("key%0d", k),
+                                                $sformatf("value_%0d_%0d", i, k)));
+    end
+
+    fd = $fopen(fname, "w");
+    `FAIL_IF(fd == 0)
+    w = cfgStreamWriter::create(fd);
+    nm.sformatTo(w);
+    w.flush();
+    Obstack#(cfgStreamWriter)::relinquish(w);
+    $fclose(fd);
+    text = file_readAll(fname);
+    `FAIL_UNLESS(text.len() > 65536)
+    `FAIL_UNLESS(text == nm.sformat())
+
+    // The same through a file serializer, read back
+    `FAIL_UNLESS_EQUAL(my_INI.openW(iniName), CFG_OK)
+    `FAIL_UNLESS_EQUAL(my_INI.serialize(nm), CFG_OK)
+    void'(my_INI.close());
+    text = file_readAll(iniName);
+    `FAIL_UNLESS(text.len() > 65536)
+    `FAIL_UNLESS_EQUAL(my_INI.openR(iniName), CFG_OK)
+    root = my_INI.deserialize();
+    err = my_INI.getLastError();
+    void'(my_INI.close());
+    `FAIL_UNLESS_EQUAL(err, CFG_OK)
+    `FAIL_IF(root == null)
+    `FAIL_UNLESS(root.sformat() == nm.sformat())
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(root, "sec199.key19"), "value_199_19")
+
+  `SVTEST_END
+
+  `SVUNIT_TESTS_END
+
+endmodule
@@ -0,0 +1,181 @@
+`include "svunit_defines.svh"
+`include "svlib_macros.svh"
+
+module Error_pkg_test_unit_test;
+  import svunit_pkg::svunit_testcase;
+  import svlib_pkg::*;
+
+  string name = "Error_pkg_test_ut";
+  svunit_testcase svunit_ut;
+
+
+  //===================================
+  // This is the UUT that we're
+  // running the Unit Tests on
+  //===================================
+
+  svlibErrorManager errorManager;
+
+  // Does ~s~ end with ~tail~?
+  function automatic bit endsWith(string s, string tail);
+    if (tail.len() > s.len()) return 0;
+    return (s.substr(s.len() - tail.len(), s.len() - 1) == tail);
+  endfunction
+
+
+  //===================================
+  // Build
+  //===================================
+  function void build();
+    svunit_ut = new(name);
+  endfunction
+
+
+  //===================================
+  // Setup for running the Unit Tests
+  //===================================
+  task setup();
+    svunit_ut.setup();
+    /* Place Setup Code Here */
+    // Start each test with no error, pending or not
+    errorManager = error_getManager();
+    void'(error_getLast());
+    errorManager.submit(0);
+  endtask
+
+
+  //===================================
+  // Here we deconstruct anything we
+  // need after running the Unit Tests
+  //===================================
+  task teardown();
+    svunit_ut.teardown();
+    /* Place Teardown Code Here */
+    error_userHandling(0);
+  endtask
+
+
+  //===================================
+  // All tests are defined between the
+  // SVUNIT_TESTS_BEGIN/END macros
+  //
+  // Each individual test must be
+  // defined between `SVTEST(_NAME_)
+  // `SVTEST_END
+  //
+  // i.e.
+  //   `SVTEST(mytest)
+  //     <test code>
+  //   `SVTEST_END
+  //===================================
+  `SVUNIT_TESTS_BEGIN
+
+  `SVTEST(Error_success_check)
+
+    qs before;
+
+    // Successes leave no error behind and nothing in the history
+    before = error_recent();
+    repeat (100) errorManager.submit(0);
+    void'(sys_getCwd());
+    void'(file_accessible("."));
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS(error_recent() == before)
+
+    // A success replaces the details of an earlier, cleared error
+    error_userHandling(1);
+    errorManager.submit(2, "earlier");
+    `FAIL_UNLESS_EQUAL(error_getLast(), 2)
+    errorManager.submit(0, "later");
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_STR_EQUAL(error_details(), "later")
+
+  `SVTEST_END
+
+  `SVTEST(Error_pending_check)
+
+    error_userHandling(1);
+    `FAIL_UNLESS(errorManager.getUserHandling())
+    errorManager.submit(2, "first");
+
+    // Looking without clearing leaves the error pending
+    `FAIL_UNLESS_EQUAL(error_getLast(0), 2)
+    `FAIL_UNLESS_EQUAL(error_getLast(0), 2)
+    `FAIL_UNLESS_STR_EQUAL(error_details(), "first")
+    `FAIL_UNLESS_STR_EQUAL(error_text(), error_text(2))
+    `FAIL_UNLESS_STR_EQUAL(error_fullMessage(), {error_text(2), " (errno=2): first"})
+
+    // Clearing it keeps its text until the next error
+    `FAIL_UNLESS_EQUAL(error_getLast(), 2)
+    `FAIL_UNLESS_STR_EQUAL(error_details(), "first")
+    errorManager.submit(13, "second");
+    `FAIL_UNLESS_EQUAL(error_getLast(), 13)
+    `FAIL_UNLESS_STR_EQUAL(error_details(), "second")
+
+    error_userHandling(0);
+    `FAIL_IF(errorManager.getUserHandling())
+
+  `SVTEST_END
+
+  `SVTEST(Error_per_process_check)
+
+    // Each process has its own error state and handling mode
+    int childErr;
+
+    error_userHandling(1);
+    fork
+      begin
+        error_userHandling(1);
+        errorManager.submit(2, "child");
+        childErr = error_getLast(0);
+      end
+    join
+    `FAIL_UNLESS_EQUAL(childErr, 2)
+    `FAIL_UNLESS_EQUAL(error_getLast(0), 0)
+
+    errorManager.submit(13, "parent");
+    fork
+      childErr = error_getLast(0);
+    join
+    `FAIL_UNLESS_EQUAL(childErr, 0)
+    `FAIL_UNLESS_EQUAL(error_getLast(), 13)
+
+    // The default applies to processes that have not chosen
+    error_userHandling(1, 1);
+    fork
+      childErr = errorManager.getUserHandling();
+    join
+    `FAIL_UNLESS_EQUAL(childErr, 1)
+    error_userHandling(0, 1);
+    fork
+      childErr = errorManager.getUserHandling();
+    join
+    `FAIL_UNLESS_EQUAL(childErr, 0)
+
+  `SVTEST_END
+
+  `SVTEST(Error_history_check)
+
+    // Only the most recent errors are kept, oldest first
+    qs  recent;
+    int total = `SVLIB_ERROR_HISTORY_SIZE + 5;
+
+    error_userHandling(1);
+    for (int i=0; i<total; i++) begin
+      errorManager.submit(22, $sformatf("history %0d", i));
+      void'(error_getLast());
+    end
+    recent = error_recent();
+    `FAIL_UNLESS_EQUAL(recent.size(), `SVLIB_ERROR_HISTORY_SIZE)
+    `FAIL_UNLESS(endsWith(recent[0], $sformatf("history %0d", total - `SVLIB_ERROR_HISTORY_SIZE)))
+    `FAIL_UNLESS(endsWith(recent[$], $sformatf("history %0d", total - 1)))
+    `FAIL_UNLESS(endsWith(recent[$], {error_text(22), " (errno=22): ", $sformatf("history %0d", total - 1)}))
+
+    // and appear in the debug report
+    `FAIL_UNLESS(error_debugReport().size() > recent.size())
+
+  `SVTEST_END
+
+  `SVUNIT_TESTS_END
+
+endmodule
@@ -115,6 +115,263 @@ module File_pkg_test_unit_test;
 
   `SVTEST_END
 
+  `SVTEST(File_normalize_relative_check)
+
+    Pathname other;
+
+    my_PN.set("/a/b/../c/./d//");
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "/a/b/../c/./d")
+    my_PN.normalize();
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "/a/c/d")
+    my_PN.set("/../x");
+    my_PN.normalize();
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "/x")
+    my_PN.set("a/../../x/./y");
+    my_PN.normalize();
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "../x/y")
+    `FAIL_UNLESS_STR_EQUAL(my_PN.tail(), "y")
+
+    // get() is cached, but must follow every change to the path
+    other = my_PN.copy();
+    `FAIL_UNLESS_STR_EQUAL(other.get(), "../x/y")
+    other.append("z.txt");
+    `FAIL_UNLESS_STR_EQUAL(other.get(), "../x/y/z.txt")
+    `FAIL_UNLESS_STR_EQUAL(other.extension(), ".txt")
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "../x/y")
+
+    my_PN.set("/a/b/c");
+    `FAIL_UNLESS_STR_EQUAL(my_PN.relativeTo("/a/d"), "../b/c")
+    `FAIL_UNLESS_STR_EQUAL(my_PN.relativeTo("/a/b/c/"), ".")
+    `FAIL_UNLESS_STR_EQUAL(my_PN.relativeTo("/"), "a/b/c")
+    my_PN.set("a/b");
+    `FAIL_UNLESS_STR_EQUAL(my_PN.relativeTo("a/c/d"), "../../b")
+
+    my_PN.set("./no_such_directory/../.");
+    error_userHandling(1);
+    `FAIL_UNLESS(my_PN.resolve() == 0)
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), "./no_such_directory/../.")
+    my_PN.set(".");
+    `FAIL_UNLESS(my_PN.resolve())
+    `FAIL_UNLESS(my_PN.isAbsolute())
+    `FAIL_UNLESS_STR_EQUAL(my_PN.get(), sys_getCwd())
+
+  `SVTEST_END
+
+  `SVTEST(File_line_reader_check)
+
+    string         fname = "File_line_reader_check.txt";
+    string         expected[$] = {"first\n", "\n", "third line\n", "no newline"};
+    string         line;
+    int            fd;
+    int            n;
+    FileLineReader reader;
+
+    fd = $fopen(fname, "w");
+    foreach (expected[i]) $fwrite(fd, "%s", expected[i]);
+    $fclose(fd);
+
+    // Batch size smaller than the file, to exercise refilling
+    reader = FileLineReader::create(fname, 3);
+    `FAIL_UNLESS(reader.isOpen())
+    n = 0;
+    while (reader.next(line)) begin
+      `FAIL_UNLESS_STR_EQUAL(line, expected[n])
+      n++;
+      `FAIL_UNLESS_EQUAL(reader.lineNumber(), n)
+    end
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+    `FAIL_UNLESS_EQUAL(reader.offset(), 18)
+    `FAIL_UNLESS(!reader.isOpen())
+
+    n = 0;
+    `foreach_mapped_line(fname, ln, lnum, 10) begin
+      `FAIL_UNLESS_STR_EQUAL(ln, expected[n])
+      `FAIL_UNLESS_EQUAL(lnum, 10+n)
+      n++;
+    end
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+
+    // A missing file yields no lines, and an error
+    error_userHandling(1);
+    reader = FileLineReader::create("File_line_reader_check.missing");
+    `FAIL_UNLESS(error_getLast() != 0)
+    `FAIL_UNLESS(!reader.next(line))
+    error_userHandling(0);
+
+  `SVTEST_END
+
+  `SVTEST(File_gz_line_reader_check)
+
+    string fname = "File_gz_line_reader_check.txt";
+    string expected[$];
+    int    n;
+
+    for (int i=0; i<5000; i++) expected.push_back($sformatf("line %0d\n", i));
+    file_writeAll(fname, str_sjoin(expected, ""));
+    `FAIL_UNLESS_EQUAL($system({"gzip -f ", fname}), 0)
+
+    n = 0;
+    `foreach_mapped_line({fname, ".gz"}, ln, lnum) begin
+      `FAIL_UNLESS_STR_EQUAL(ln, expected[n])
+      n++;
+    end
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+
+  `SVTEST_END
+
+  `SVTEST(File_gz_long_line_check)
+
+    // Several MiB of text with one line longer than a whole
+    // decompression chunk (SVLIB_GZ_CHUNK_SIZE, 1 MiB)
+    string fname = "File_gz_long_line_check.txt";
+    string expected[$];
+    string long_line;
+    int    n, bad;
+
+    long_line = {1536*1024{"x"}};
+    for (int i=0; i<300000; i++) begin
+      if (i == 150000) expected.push_back({long_line, "\n"});
+      expected.push_back($sformatf("line %0d\n", i));
+    end
+    file_writeAll(fname, str_sjoin(expected, ""));
+    `FAIL_UNLESS_EQUAL($system({"gzip -f ", fname}), 0)
+
+    n = 0;
+    bad = 0;
+    `foreach_mapped_line({fname, ".gz"}, ln, lnum) begin
+      if ((n >= expected.size()) || (ln != expected[n])) bad++;
+      n++;
+    end
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+    `FAIL_UNLESS_EQUAL(bad, 0)
+
+  `SVTEST_END
+
+  `SVTEST(File_gz_members_check)
+
+    // Several gzip members one after another read as one text, and
+    // zero padding after the last member is ignored, as gzip -d does
+    string fname = "File_gz_members_check";
+    string expected[$] = {"one\n", "two\n", "three\n", "no newline"};
+    int    n;
+
+    file_writeAll({fname, "_1.txt"}, {expected[0], expected[1]});
+    file_writeAll({fname, "_2.txt"}, {expected[2], expected[3]});
+    `FAIL_UNLESS_EQUAL($system({"gzip -c ", fname, "_1.txt > ", fname, ".gz"}), 0)
+    `FAIL_UNLESS_EQUAL($system({"gzip -c ", fname, "_2.txt >> ", fname, ".gz"}), 0)
+
+    n = 0;
+    `foreach_mapped_line({fname, ".gz"}, ln, lnum) begin
+      `FAIL_UNLESS_STR_EQUAL(ln, expected[n])
+      n++;
+    end
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+
+    `FAIL_UNLESS_EQUAL($system({"head -c 512 /dev/zero >> ", fname, ".gz"}), 0)
+    n = 0;
+    `foreach_mapped_line({fname, ".gz"}, ln, lnum) begin
+      `FAIL_UNLESS_STR_EQUAL(ln, expected[n])
+      n++;
+    end
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_EQUAL(n, expected.size())
+
+  `SVTEST_END
+
+  `SVTEST(File_gz_truncated_check)
+
+    // The lines before the damage are delivered, then an error
+    string fname = "File_gz_truncated_check.txt";
+    string expected[$];
+    int    n, bad;
+
+    for (int i=0; i<100000; i++) expected.push_back($sformatf("line %0d\n", i));
+    file_writeAll(fname, str_sjoin(expected, ""));
+    `FAIL_UNLESS_EQUAL($system({"gzip -c ", fname, " | head -c 100000 > ", fname, ".gz"}), 0)
+
+    error_userHandling(1);
+    n = 0;
+    bad = 0;
+    `foreach_mapped_line({fname, ".gz"}, ln, lnum) begin
+      if ((n >= expected.size()) || (ln != expected[n])) bad++;
+      n++;
+    end
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+    `FAIL_UNLESS(n > 0)
+    `FAIL_UNLESS(n < expected.size())
+    `FAIL_UNLESS_EQUAL(bad, 0)
+
+  `SVTEST_END
+
+  `SVTEST(File_readAll_writeAll_check)
+
+    string fname = "File_readAll_writeAll_check.txt";
+
+    file_writeAll(fname, "hello\n");
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS_STR_EQUAL(file_readAll(fname), "hello\n")
+    file_writeAll(fname, "world\n", 1);
+    `FAIL_UNLESS_STR_EQUAL(file_readAll(fname), "hello\nworld\n")
+    `FAIL_UNLESS_EQUAL(file_size(fname), 12)
+    file_writeAll(fname, "");
+    `FAIL_UNLESS_STR_EQUAL(file_readAll(fname), "")
+
+    error_userHandling(1);
+    `FAIL_UNLESS_STR_EQUAL(file_readAll("File_readAll_writeAll_check.missing"), "")
+    `FAIL_UNLESS(error_getLast() != 0)
+    file_writeAll("no_such_directory/x.txt", "x");
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+
+  `SVTEST_END
+
+  `SVTEST(File_logSink_check)
+
+    string          fname = "File_logSink_check.log";
+    LogSink         sink;
+    logSink_stats_s stats;
+    qs              lines;
+
+    sink = LogSink::create(fname);
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    `FAIL_UNLESS(sink.isOpen())
+    for (int i=0; i<1000; i++) sink.write($sformatf("line %0d", i));
+    sink.flush();
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    lines = str_split(file_readAll(fname), "\n");
+    `FAIL_UNLESS_EQUAL(lines.size(), 1001)
+    `FAIL_UNLESS_STR_EQUAL(lines[0], "line 0")
+    `FAIL_UNLESS_STR_EQUAL(lines[999], "line 999")
+    stats = sink.getStats();
+    `FAIL_UNLESS_EQUAL(stats.lines, 1000)
+    `FAIL_UNLESS_EQUAL(stats.written, stats.bytes)
+    sink.close();
+    `FAIL_UNLESS(!sink.isOpen())
+
+    // Timestamps, appending to the same file
+    sink = LogSink::create(fname, "[%Y] ", 1);
+    sink.write("stamped");
+    sink.close();
+    lines = str_split(file_readAll(fname), "\n");
+    `FAIL_UNLESS_EQUAL(lines.size(), 1002)
+    `FAIL_UNLESS_STR_EQUAL(lines[1000], {"[", sys_formatTime(sys_dayTime(), "%Y"), "] stamped"})
+
+    error_userHandling(1);
+    sink = LogSink::create("no_such_directory/x.log");
+    `FAIL_UNLESS(error_getLast() != 0)
+    `FAIL_UNLESS(!sink.isOpen())
+    sink.write("nowhere");
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+
+  `SVTEST_END
+
   `SVUNIT_TESTS_END
 
 endmodule
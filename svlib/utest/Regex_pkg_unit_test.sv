@@ -184,6 +184,23 @@ module Regex_pkg_test_unit_test;
 
   `SVTEST_END
 
+  `SVTEST(RE_substAll_long_check)
+  int count;
+  str.set(str_repeat("<ab>", 1000));
+  re = Regex::create("<(a)(b)>");
+  re.setStr(str);
+  count = re.substAll("$2$1");
+  `FAIL_UNLESS_EQUAL(count,1000)
+  `FAIL_UNLESS_STR_EQUAL(str.get(), str_repeat("ba", 1000))
+  // Single substitution leaves the match information available
+  str.set("x=<ab>, y=<ab>");
+  count = re.subst("[$&]", 3);
+  `FAIL_UNLESS_EQUAL(count,1)
+  `FAIL_UNLESS_STR_EQUAL(str.get(), "x=<ab>, y=[<ab>]")
+  `FAIL_UNLESS_EQUAL(re.getMatchStart(0), 10)
+  `FAIL_UNLESS_EQUAL(re.getMatchStart(2), 12)
+  `SVTEST_END
+
   `SVTEST(regsub_emptymatch_check)
   int count;
   re.setRE("");
@@ -217,6 +234,144 @@ module Regex_pkg_test_unit_test;
   `FAIL_UNLESS_STR_EQUAL(str.get(), "#")
   `SVTEST_END
 
+  `SVTEST(regex_split_check)
+  string expected[$];
+  string actual[$];
+
+  actual = regex_split(",,foo,bar,,", ",");
+  expected = {"", "", "foo", "bar"};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+
+  actual = regex_split(",,foo,bar,,", ",", -1);
+  expected = {"", "", "foo", "bar", "", ""};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+
+  actual = regex_split(",,foo,bar,,", ",", 3);
+  expected = {"", "", "foo"};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+
+  actual = regex_split("sum  =  first +second- third", "\\s*([+=-])\\s*");
+  expected = {"sum", "=", "first", "+", "second", "-", "third"};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+
+  actual = regex_split("foobar", "");
+  expected = {"f", "o", "o", "b", "a", "r"};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+
+  actual = regex_split("", ",");
+  expected = {};
+  `FAIL_UNLESS_EQUAL(expected, actual)
+  `SVTEST_END
+
+  `SVTEST(regex_cache_check)
+  regex_cacheStats_s before, after;
+  before = regex_cacheStats();
+  `FAIL_UNLESS(before.capacity > 0)
+  `FAIL_UNLESS(before.entries <= before.capacity)
+  // Same pattern used repeatedly, through different Regex objects:
+  // compiled at most once, all other lookups should hit the cache.
+  for (int i=0; i<10; i++) begin
+    re = regex_match("cached pattern check", "pat+ern");
+    `FAIL_IF(re == null)
+  end
+  after = regex_cacheStats();
+  `FAIL_UNLESS(after.misses - before.misses <= 1)
+  `FAIL_UNLESS(after.hits - before.hits >= 9)
+  // One Regex object re-run on the same RE does not look it up again
+  before = after;
+  re = Regex::create("a+");
+  str.set("baaad");
+  for (int i=0; i<10; i++) begin
+    `FAIL_UNLESS(re.test(str))
+    `FAIL_UNLESS_EQUAL(re.getMatchLength(), 3)
+  end
+  after = regex_cacheStats();
+  `FAIL_UNLESS_EQUAL(after.hits + after.misses, before.hits + before.misses + 1)
+  // Changing the options must give a differently-compiled RE
+  re.setOpts(Regex::NOCASE);
+  str.set("bAaAd");
+  `FAIL_UNLESS(re.test(str))
+  `FAIL_UNLESS_EQUAL(re.getMatchLength(), 3)
+  `SVTEST_END
+
+  `SVTEST(regex_grep_check)
+  string lines[$] = {"error: foo 12", "ok", "ERROR: bar 7", "", "warning: error"};
+  string caps[$][$];
+  int    hits[$];
+
+  hits = regex_grep(lines, "error");
+  `FAIL_UNLESS_EQUAL(hits.size(), 2)
+  `FAIL_UNLESS_EQUAL(hits[0], 0)
+  `FAIL_UNLESS_EQUAL(hits[1], 4)
+
+  hits = regex_grep(lines, "^error", Regex::NOCASE);
+  `FAIL_UNLESS_EQUAL(hits.size(), 2)
+  `FAIL_UNLESS_EQUAL(hits[0], 0)
+  `FAIL_UNLESS_EQUAL(hits[1], 2)
+
+  hits = regex_grep(lines, "^$");
+  `FAIL_UNLESS_EQUAL(hits.size(), 1)
+  `FAIL_UNLESS_EQUAL(hits[0], 3)
+
+  hits = regex_grep(lines, "nowhere");
+  `FAIL_UNLESS_EQUAL(hits.size(), 0)
+
+  hits = regex_grepCaptures(lines, "^([a-z]+): ([a-z]+)( [0-9]+)?", caps, Regex::NOCASE);
+  `FAIL_UNLESS_EQUAL(hits.size(), 3)
+  `FAIL_UNLESS_EQUAL(caps.size(), 3)
+  `FAIL_UNLESS_EQUAL(hits[1], 2)
+  `FAIL_UNLESS_EQUAL(caps[1].size(), 4)
+  `FAIL_UNLESS_STR_EQUAL(caps[1][0], "ERROR: bar 7")
+  `FAIL_UNLESS_STR_EQUAL(caps[1][1], "ERROR")
+  `FAIL_UNLESS_STR_EQUAL(caps[1][2], "bar")
+  `FAIL_UNLESS_STR_EQUAL(caps[1][3], " 7")
+  `FAIL_UNLESS_STR_EQUAL(caps[2][2], "error")
+  `FAIL_UNLESS_STR_EQUAL(caps[2][3], "")
+  `SVTEST_END
+
+  `SVTEST(scanVerilogInt_check)
+  logic signed [63:0]  v;
+  logic signed [63:0]  vs[$];
+  logic signed [127:0] big;
+  bit                  ok[$];
+
+  `FAIL_UNLESS(scanVerilogInt(" 42 ", v))
+  `FAIL_UNLESS_EQUAL(v, 42)
+  `FAIL_UNLESS(scanVerilogInt("-'hFF", v))
+  `FAIL_UNLESS_EQUAL(v, -255)
+  `FAIL_UNLESS(scanVerilogInt("8'sb1000_0000", v))
+  `FAIL_UNLESS_EQUAL(v, -128)
+  `FAIL_UNLESS(scanVerilogInt("12'h3_4", v))
+  `FAIL_UNLESS(v === 64'h34)
+  `FAIL_UNLESS(scanVerilogInt("8'hx", v))
+  `FAIL_UNLESS(v === 64'h0000_0000_0000_00xx)
+  `FAIL_UNLESS(scanVerilogInt("z", v))
+  `FAIL_UNLESS(v === 'z)
+  // Failure leaves the result untouched
+  v = 7;
+  `FAIL_IF(scanVerilogInt("8'd12a", v))
+  `FAIL_IF(scanVerilogInt("'s4hF", v))
+  `FAIL_IF(scanVerilogInt("_", v))
+  // Control bytes are not digits
+  `FAIL_IF(scanVerilogInt("8'h\x11", v))
+  `FAIL_IF(scanVerilogInt("'b\x10", v))
+  `FAIL_IF(scanVerilogInt("1\x19", v))
+  `FAIL_UNLESS_EQUAL(v, 7)
+
+  `FAIL_UNLESS_EQUAL(scanVerilogIntMany({"1", "bad", "'o17", ""}, vs, ok), 2)
+  `FAIL_UNLESS_EQUAL(vs.size(), 4)
+  `FAIL_UNLESS_EQUAL(ok.size(), 4)
+  `FAIL_UNLESS(ok[0] && !ok[1] && ok[2] && !ok[3])
+  `FAIL_UNLESS_EQUAL(vs[2], 15)
+  `FAIL_UNLESS($isunknown(vs[1]))
+
+  `FAIL_UNLESS(VerilogInt#(128)::scan("128'h0123456789abcdef_fedcba9876543210", big))
+  `FAIL_UNLESS(big === 128'h0123456789abcdef_fedcba9876543210)
+  `FAIL_UNLESS(VerilogInt#(128)::scan("-1", big))
+  `FAIL_UNLESS(big === -128'sd1)
+  `FAIL_UNLESS(VerilogInt#(128)::scan("'s4hF", big) == 0)
+  `SVTEST_END
+
 
   `SVUNIT_TESTS_END
 
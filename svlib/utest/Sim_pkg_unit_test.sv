@@ -0,0 +1,237 @@
+`include "svunit_defines.svh"
+`include "svlib_macros.svh"
+
+module Sim_pkg_test_unit_test;
+  import svunit_pkg::svunit_testcase;
+  import svlib_pkg::*;
+
+  string name = "Sim_pkg_test_ut";
+  svunit_testcase svunit_ut;
+
+
+  //===================================
+  // This is the UUT that we're
+  // running the Unit Tests on
+  //===================================
+
+  // Plusargs parsed from a made-up command line instead of the real one
+  class Plusargs_test extends Plusargs;
+    // Make ~cmdLine~ the command line for every Plusargs lookup,
+    // returning the previous database so it can be restored
+    static function Plusargs install(qs cmdLine);
+      Plusargs_test db = new();
+      db.parse(cmdLine);
+      install   = singleton;
+      singleton = db;
+    endfunction
+    static function void restore(Plusargs saved);
+      singleton = saved;
+    endfunction
+  endclass
+
+  typedef enum {SLOW, FAST} mode_e;
+
+  qs cmdLine = '{"-f", "run.f", "+seed=42", "+verbose", "+define+A+B",
+                 "+seeds=1,2", "+seeds=3", "+mode=FAST", "+badmode=MEDIUM",
+                 "+hex='hFF", "+bad=twelve", "+opt=a=b", "+x=1+2", "+p+q=r",
+                 "+empty=", "+", "plain"};
+
+  Plusargs saved;
+
+  // The text of the scalar at ~path~ below ~root~, or "<missing>"
+  function automatic string scalarAt(cfgNode root, string path);
+    cfgNodeScalar ns;
+    if (!$cast(ns, root.lookup(path)) || (ns == null)) return "<missing>";
+    return ns.value.str();
+  endfunction
+
+  // Is the node at ~path~ below ~root~ an integer scalar?
+  function automatic bit isIntAt(cfgNode root, string path);
+    cfgNodeScalar ns;
+    cfgScalarInt  csi;
+    if (!$cast(ns, root.lookup(path)) || (ns == null)) return 0;
+    return $cast(csi, ns.value);
+  endfunction
+
+
+  //===================================
+  // Build
+  //===================================
+  function void build();
+    svunit_ut = new(name);
+  endfunction
+
+
+  //===================================
+  // Setup for running the Unit Tests
+  //===================================
+  task setup();
+    svunit_ut.setup();
+    /* Place Setup Code Here */
+    // Each test starts with nothing looked up or declared
+    saved = Plusargs_test::install(cmdLine);
+  endtask
+
+
+  //===================================
+  // Here we deconstruct anything we
+  // need after running the Unit Tests
+  //===================================
+  task teardown();
+    svunit_ut.teardown();
+    /* Place Teardown Code Here */
+    Plusargs_test::restore(saved);
+    error_userHandling(0);
+  endtask
+
+
+  //===================================
+  // All tests are defined between the
+  // SVUNIT_TESTS_BEGIN/END macros
+  //
+  // Each individual test must be
+  // defined between `SVTEST(_NAME_)
+  // `SVTEST_END
+  //
+  // i.e.
+  //   `SVTEST(mytest)
+  //     <test code>
+  //   `SVTEST_END
+  //===================================
+  `SVUNIT_TESTS_BEGIN
+
+  `SVTEST(Plusargs_parse_check)
+
+    // Only plusargs are indexed, in order of first appearance
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::getNames(), " "),
+                           "seed verbose define seeds mode badmode hex bad opt x p empty")
+
+    `FAIL_UNLESS(Plusargs::has("seed"))
+    `FAIL_UNLESS(Plusargs::has("verbose"))
+    `FAIL_IF(Plusargs::has("run.f"))
+    `FAIL_IF(Plusargs::has("plain"))
+    `FAIL_IF(Plusargs::has("nothere"))
+
+    // +name=value, +name, +name+v1+v2 and repeats
+    `FAIL_UNLESS_EQUAL(Plusargs::count("seed"),    1)
+    `FAIL_UNLESS_EQUAL(Plusargs::count("verbose"), 0)
+    `FAIL_UNLESS_EQUAL(Plusargs::count("define"),  2)
+    `FAIL_UNLESS_EQUAL(Plusargs::count("seeds"),   2)
+    `FAIL_UNLESS_EQUAL(Plusargs::count("nothere"), 0)
+
+    // Whichever of '=' and '+' comes first separates name from value
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("opt"), "a=b")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("x"),   "1+2")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("p"),   "q=r")
+
+  `SVTEST_END
+
+  `SVTEST(Plusargs_getters_check)
+
+    // Single-value getters use the first occurrence
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("seed"), "42")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("seeds"), "1,2")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("define"), "A")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("verbose", "none"), "none")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("nothere", "none"), "none")
+    `FAIL_UNLESS_STR_EQUAL(Plusargs::getString("empty", "none"), "")
+
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("seed"), 42)
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("hex"), 255)
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("nothere", 7), 7)
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("verbose", 7), 7)
+
+    // A value that is not an integer is an error
+    error_userHandling(1);
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("bad", 7), 7)
+    `FAIL_UNLESS_EQUAL(error_getLast(), -1)
+    `FAIL_UNLESS_EQUAL(Plusargs::getInt("seed", 7), 42)
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    error_userHandling(0);
+
+    // Lists join every occurrence, split at commas
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::getList("seeds"), " "),  "1 2 3")
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::getList("define"), " "), "A B")
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::getList("verbose"), " "), "")
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::getList("nothere"), " "), "")
+
+  `SVTEST_END
+
+  `SVTEST(PlusargEnum_check)
+
+    `FAIL_UNLESS_EQUAL(PlusargEnum#(mode_e)::get("mode", SLOW), FAST)
+    `FAIL_UNLESS_EQUAL(PlusargEnum#(mode_e)::get("nothere", FAST), FAST)
+    `FAIL_UNLESS_EQUAL(PlusargEnum#(mode_e)::get("verbose", SLOW), SLOW)
+
+    // A value that is not an enumerator is an error
+    error_userHandling(1);
+    `FAIL_UNLESS_EQUAL(PlusargEnum#(mode_e)::get("badmode", SLOW), SLOW)
+    `FAIL_UNLESS_EQUAL(error_getLast(), -1)
+    `FAIL_UNLESS_EQUAL(PlusargEnum#(mode_e)::get("mode", SLOW), FAST)
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    error_userHandling(0);
+
+  `SVTEST_END
+
+  `SVTEST(Plusargs_unused_check)
+
+    qs names;
+
+    names = Plusargs::getNames();
+
+    // toDOM does not count as a lookup
+    void'(Plusargs::toDOM());
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::unused(), " "), str_sjoin(names, " "))
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::unknown(), " "), str_sjoin(names, " "))
+
+    // Every kind of lookup counts, even of a name that is absent
+    void'(Plusargs::has("seed"));
+    void'(Plusargs::count("verbose"));
+    void'(Plusargs::getString("define"));
+    void'(Plusargs::getInt("hex"));
+    void'(Plusargs::getList("seeds"));
+    void'(PlusargEnum#(mode_e)::get("mode", SLOW));
+    void'(Plusargs::has("nothere"));
+    Plusargs::declare('{"opt", "x", "nothere"});
+
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::unused(), " "),  "badmode bad opt x p empty")
+    `FAIL_UNLESS_STR_EQUAL(str_sjoin(Plusargs::unknown(), " "), "badmode bad p empty")
+
+  `SVTEST_END
+
+  `SVTEST(Plusargs_toDOM_check)
+
+    cfgNodeMap dom;
+    qs         names;
+
+    dom   = Plusargs::toDOM("args");
+    names = Plusargs::getNames();
+    `FAIL_UNLESS_STR_EQUAL(dom.getName(), "args")
+    `FAIL_UNLESS_EQUAL(dom.value.num(), names.size())
+
+    // A flag is 1, a value is an integer if it can be
+    `FAIL_UNLESS(isIntAt(dom, "verbose"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "verbose"), "1")
+    `FAIL_UNLESS(isIntAt(dom, "seed"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "seed"), "42")
+    `FAIL_UNLESS(isIntAt(dom, "hex"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "hex"), "255")
+    `FAIL_IF(isIntAt(dom, "mode"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "mode"), "FAST")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "opt"), "a=b")
+
+    // Several values make a sequence, without splitting at commas
+    `FAIL_UNLESS_EQUAL(dom.lookup("define").kind(), NODE_SEQUENCE)
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "define[0]"), "A")
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "define[1]"), "B")
+    `FAIL_UNLESS_EQUAL(dom.lookup("seeds").kind(), NODE_SEQUENCE)
+    `FAIL_IF(isIntAt(dom, "seeds[0]"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "seeds[0]"), "1,2")
+    `FAIL_UNLESS(isIntAt(dom, "seeds[1]"))
+    `FAIL_UNLESS_STR_EQUAL(scalarAt(dom, "seeds[1]"), "3")
+
+  `SVTEST_END
+
+  `SVUNIT_TESTS_END
+
+endmodule
@@ -300,6 +300,43 @@ module Str_pkg_test_unit_test;
   `FAIL_UNLESS_EQUAL(my_Str.first(sought),     -1);
   `FAIL_UNLESS_EQUAL(my_Str.last (sought),     -1);
 
+  // Long enough to take the skip-table search path
+  my_Str.set("abcabcabdabcabcabcabdx");
+  sought = "abcabcabd";
+  `FAIL_UNLESS_EQUAL(my_Str.first(sought),      0);
+  `FAIL_UNLESS_EQUAL(my_Str.first(sought, 1),  12);
+  `FAIL_UNLESS_EQUAL(my_Str.last (sought),     12);
+  `FAIL_UNLESS_EQUAL(my_Str.last (sought, 1),   0);
+
+  // Empty substring
+  sought = "";
+  `FAIL_UNLESS_EQUAL(my_Str.first(sought, 3),   3);
+  `FAIL_UNLESS_EQUAL(my_Str.last (sought, 3),  19);
+
+  `SVTEST_END
+
+  `SVTEST(Str_count_check)
+
+  int found[$];
+
+  my_Str.set("aaaaa");
+  `FAIL_UNLESS_EQUAL(my_Str.count("a"),   5)
+  `FAIL_UNLESS_EQUAL(my_Str.count("aa"),  2)
+  `FAIL_UNLESS_EQUAL(my_Str.count("b"),   0)
+  `FAIL_UNLESS_EQUAL(my_Str.count(""),    0)
+  found = my_Str.findAll("aa");
+  `FAIL_UNLESS_EQUAL(found.size(), 2)
+  `FAIL_UNLESS_EQUAL(found[0], 0)
+  `FAIL_UNLESS_EQUAL(found[1], 2)
+
+  my_Str.set("one, two, three");
+  found = my_Str.findAll(", ");
+  `FAIL_UNLESS_EQUAL(found.size(), 2)
+  `FAIL_UNLESS_EQUAL(found[0], 3)
+  `FAIL_UNLESS_EQUAL(found[1], 8)
+  found = my_Str.findAll("four");
+  `FAIL_UNLESS_EQUAL(found.size(), 0)
+
   `SVTEST_END
 
   `SVTEST(Str_split_check)
@@ -361,6 +398,34 @@ module Str_pkg_test_unit_test;
   actual = my_Str.split("ab");
   `FAIL_UNLESS_EQUAL(expected, actual);
 
+  // Whitespace in the splitset swallows any further whitespace
+  my_Str.set("a b  c, \t d");
+  actual = my_Str.split(" ");
+  expected = {"a", "b", "c,", "d"};
+  `FAIL_UNLESS_EQUAL(expected, actual);
+
+  actual = my_Str.split(", ", 1);
+  expected = {"a", " ", "b", " ", "c", ",", "d"};
+  `FAIL_UNLESS_EQUAL(expected, actual);
+
+  `SVTEST_END
+
+  `SVTEST(Str_strip_check)
+
+  my_Str.set(" a\tb c\n");
+  my_Str.strip();
+  `FAIL_UNLESS_STR_EQUAL(my_Str.get(), "abc")
+
+  my_Str.set("--a-b--");
+  my_Str.strip("-");
+  `FAIL_UNLESS_STR_EQUAL(my_Str.get(), "ab")
+  my_Str.strip("ab");
+  `FAIL_UNLESS_STR_EQUAL(my_Str.get(), "")
+
+  my_Str.set("abc");
+  my_Str.strip("");
+  `FAIL_UNLESS_STR_EQUAL(my_Str.get(), "abc")
+
   `SVTEST_END
 
   `SVTEST(Str_join_check)
@@ -396,6 +461,61 @@ module Str_pkg_test_unit_test;
   `SVTEST_END
 
 
+  `SVTEST(Str_pool_check)
+
+  int             capacity = ObjectPool#(Str)::getCapacity();
+  pool_counters_s before, after;
+  Str             objs[5];
+  string          report[$];
+  string          expected;
+  bit             found;
+
+  ObjectPool#(Str)::setCapacity(3);
+  `FAIL_UNLESS_EQUAL(ObjectPool#(Str)::getCapacity(), 3)
+  ObjectPool#(Str)::preallocate(10);
+  before = ObjectPool#(Str)::getCounters();
+  `FAIL_UNLESS_EQUAL(before.capacity, 3)
+  `FAIL_UNLESS_EQUAL(before.depth, 3)
+  `FAIL_UNLESS(before.highWater >= 3)
+  `FAIL_UNLESS_EQUAL(before.live, before.constructed - before.discarded - before.depth)
+
+  // The report has the same numbers
+  expected = $sformatf(
+    ": capacity=%0d depth=%0d highWater=%0d constructed=%0d obtained=%0d relinquished=%0d discarded=%0d live=%0d",
+    before.capacity, before.depth, before.highWater, before.constructed,
+    before.obtained, before.relinquished, before.discarded, before.live);
+  report = pool_report();
+  foreach (report[i]) begin
+    my_Str.set(report[i]);
+    if (my_Str.first(expected) >= 0) found = 1;
+  end
+  `FAIL_UNLESS(found)
+
+  // Three spares are used up, then two more objects must be constructed
+  foreach (objs[i]) objs[i] = Str::create();
+  after = ObjectPool#(Str)::getCounters();
+  `FAIL_UNLESS_EQUAL(after.depth, 0)
+  `FAIL_UNLESS_EQUAL(after.obtained, before.obtained + 5)
+  `FAIL_UNLESS_EQUAL(after.constructed, before.constructed + 2)
+  `FAIL_UNLESS_EQUAL(after.live, before.live + 5)
+
+  // Shrinking the pool discards spares
+  ObjectPool#(Str)::preallocate(3);
+  ObjectPool#(Str)::setCapacity(1);
+  after = ObjectPool#(Str)::getCounters();
+  `FAIL_UNLESS_EQUAL(after.depth, 1)
+  `FAIL_UNLESS_EQUAL(after.constructed, before.constructed + 5)
+  `FAIL_UNLESS_EQUAL(after.discarded, before.discarded + 2)
+
+  pool_setFastAllocation(1);
+  `FAIL_UNLESS(pool_getFastAllocation())
+  pool_setFastAllocation(0);
+  `FAIL_IF(pool_getFastAllocation())
+
+  ObjectPool#(Str)::setCapacity(capacity);
+  `SVTEST_END
+
+
   `SVUNIT_TESTS_END
 
 endmodule
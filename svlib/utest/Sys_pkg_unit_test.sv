@@ -0,0 +1,424 @@
+`include "svunit_defines.svh"
+`include "svlib_macros.svh"
+
+module Sys_pkg_test_unit_test;
+  import svunit_pkg::svunit_testcase;
+  import svlib_pkg::*;
+
+  string name = "Sys_pkg_test_ut";
+  svunit_testcase svunit_ut;
+
+
+  //===================================
+  // This is the UUT that we're
+  // running the Unit Tests on
+  //===================================
+
+  // A small directory tree:
+  //   x.log  a/  a/y.log  a/b/  a/b/w.txt  a/b/c/  a/b/c/z.log
+  //   lnk -> a  (symbolic link)  a/b/up -> ../..  (a loop)
+  string tree = "Sys_pkg_unit_test_tree";
+
+  // Walk the whole of ~w~, returning the depth of each path found
+  function automatic void walkAll(DirWalker w, output int depths[string],
+                                  output sys_fileStat_s stats[string],
+                                  output string order[$]);
+    string         path;
+    sys_fileStat_s stat;
+    while (w.next(path, stat)) begin
+      depths[path] = w.depth();
+      stats[path]  = stat;
+      order.push_back(path);
+    end
+  endfunction
+
+  // Paths of ~depths~ below the tree, sorted, in one string
+  function automatic string pathList(int depths[string]);
+    qs paths;
+    foreach (depths[p]) paths.push_back(p.substr(tree.len()+1, p.len()-1));
+    return str_sjoin(paths, " ");
+  endfunction
+
+
+  //===================================
+  // Build
+  //===================================
+  function void build();
+    svunit_ut = new(name);
+  endfunction
+
+
+  //===================================
+  // Setup for running the Unit Tests
+  //===================================
+  task setup();
+    svunit_ut.setup();
+    /* Place Setup Code Here */
+    void'($system({"rm -rf ", tree, " && mkdir -p ", tree, "/a/b/c && cd ", tree,
+                   " && touch a/y.log a/b/c/z.log && echo hello > x.log && echo w > a/b/w.txt",
+                   " && ln -s a lnk && ln -s ../.. a/b/up"}));
+  endtask
+
+
+  //===================================
+  // Here we deconstruct anything we
+  // need after running the Unit Tests
+  //===================================
+  task teardown();
+    svunit_ut.teardown();
+    /* Place Teardown Code Here */
+    void'($system({"rm -rf ", tree}));
+  endtask
+
+
+  //===================================
+  // All tests are defined between the
+  // SVUNIT_TESTS_BEGIN/END macros
+  //
+  // Each individual test must be
+  // defined between `SVTEST(_NAME_)
+  // `SVTEST_END
+  //
+  // i.e.
+  //   `SVTEST(mytest)
+  //     <test code>
+  //   `SVTEST_END
+  //===================================
+  `SVUNIT_TESTS_BEGIN
+
+  `SVTEST(DirWalker_all_check)
+
+    DirWalker      w;
+    int            depths[string];
+    sys_fileStat_s stats[string];
+    string         order[$];
+    int            pos[string];
+
+    // A batch size of 2 makes the walker fetch many batches
+    w = DirWalker::create(tree, .batchSize(2));
+    `FAIL_UNLESS(w.isOpen())
+    `FAIL_UNLESS_STR_EQUAL(w.getRoot(), tree)
+    walkAll(w, depths, stats, order);
+    `FAIL_IF(w.isOpen())
+    `FAIL_UNLESS_EQUAL(w.skipped(), 0)
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths),
+                           "a a/b a/b/c a/b/c/z.log a/b/up a/b/w.txt a/y.log lnk x.log")
+    `FAIL_UNLESS_EQUAL(order.size(), depths.num())
+
+    `FAIL_UNLESS_EQUAL(depths[{tree, "/x.log"}],       1)
+    `FAIL_UNLESS_EQUAL(depths[{tree, "/a/b"}],         2)
+    `FAIL_UNLESS_EQUAL(depths[{tree, "/a/b/c/z.log"}], 4)
+
+    // Each directory comes before its contents
+    foreach (order[i]) pos[order[i]] = i;
+    `FAIL_UNLESS(pos[{tree, "/a"}]     < pos[{tree, "/a/y.log"}])
+    `FAIL_UNLESS(pos[{tree, "/a/b"}]   < pos[{tree, "/a/b/c"}])
+    `FAIL_UNLESS(pos[{tree, "/a/b/c"}] < pos[{tree, "/a/b/c/z.log"}])
+
+    // The stat data comes with each entry; links are not followed
+    `FAIL_UNLESS_EQUAL(stats[{tree, "/x.log"}].size, 6)
+    `FAIL_UNLESS(stats[{tree, "/x.log"}] == sys_fileStat({tree, "/x.log"}))
+    `FAIL_UNLESS_EQUAL(stats[{tree, "/a/b"}].mode.fType, fTypeDir)
+    `FAIL_UNLESS_EQUAL(stats[{tree, "/lnk"}].mode.fType, fTypeSymLink)
+
+  `SVTEST_END
+
+  `SVTEST(DirWalker_filter_check)
+
+    DirWalker      w;
+    int            depths[string];
+    sys_fileStat_s stats[string];
+    string         order[$];
+
+    // Glob and regular expression patterns match the name only
+    w = DirWalker::create(tree, "*.log");
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a/b/c/z.log a/y.log x.log")
+
+    w = DirWalker::create(tree, "^[xy]\\.log$", .isRegex(1));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a/y.log x.log")
+
+    // No directory deeper than maxDepth is read
+    w = DirWalker::create(tree, .maxDepth(1));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a lnk x.log")
+    w = DirWalker::create(tree, .maxDepth(2));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a a/b a/y.log lnk x.log")
+
+    // Only entries of the given types are returned, but every
+    // directory is searched
+    w = DirWalker::create(tree, .types('{fTypeDir}));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a a/b a/b/c")
+    w = DirWalker::create(tree, "*.txt", .types('{fTypeFile, fTypeSymLink}));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths), "a/b/w.txt")
+
+  `SVTEST_END
+
+  `SVTEST(DirWalker_links_check)
+
+    DirWalker      w;
+    int            depths[string];
+    sys_fileStat_s stats[string];
+    string         order[$];
+
+    // Following links, the link to a/ is searched like a/ itself, but
+    // the loop back to the root is noticed and not followed
+    w = DirWalker::create(tree, "*.log", .followLinks(1));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_EQUAL(w.skipped(), 0)
+    `FAIL_UNLESS_STR_EQUAL(pathList(depths),
+                           "a/b/c/z.log a/y.log lnk/b/c/z.log lnk/y.log x.log")
+
+    w = DirWalker::create(tree, "lnk", .followLinks(1));
+    walkAll(w, depths, stats, order);
+    `FAIL_UNLESS_EQUAL(stats[{tree, "/lnk"}].mode.fType, fTypeDir)
+
+  `SVTEST_END
+
+  `SVTEST(DirWalker_errors_check)
+
+    DirWalker      w;
+    string         path;
+    sys_fileStat_s stat;
+
+    // A missing root yields nothing, and an error
+    error_userHandling(1);
+    w = DirWalker::create({tree, "/missing"});
+    `FAIL_UNLESS(error_getLast() != 0)
+    `FAIL_IF(w.isOpen())
+    `FAIL_IF(w.next(path, stat))
+
+    // A bad regular expression is an error too
+    w = DirWalker::create(tree, "(", .isRegex(1));
+    `FAIL_UNLESS(error_getLast() != 0)
+    `FAIL_IF(w.next(path, stat))
+    error_userHandling(0);
+
+    // Closing early releases the walk
+    w = DirWalker::create(tree, .batchSize(1));
+    `FAIL_UNLESS(w.next(path, stat))
+    w.close();
+    `FAIL_IF(w.isOpen())
+    `FAIL_IF(w.next(path, stat))
+
+  `SVTEST_END
+
+  `SVTEST(sys_fileStatMany_check)
+
+    qs                  paths;
+    sys_fileStatResults results;
+
+    // A path that cannot be stat'ed is not an svlib error
+    paths = '{{tree, "/x.log"}, {tree, "/missing"}, {tree, "/a"}, {tree, "/lnk"}};
+    error_userHandling(1);
+    results = sys_fileStatMany(paths);
+    `FAIL_UNLESS_EQUAL(error_getLast(), 0)
+    error_userHandling(0);
+
+    `FAIL_UNLESS_EQUAL(results.size(), paths.size())
+    `FAIL_UNLESS_EQUAL(results[0].err, 0)
+    `FAIL_UNLESS_EQUAL(results[1].err, 2)  // ENOENT
+    `FAIL_UNLESS_EQUAL(results[2].err, 0)
+    `FAIL_UNLESS_EQUAL(results[3].err, 0)
+    `FAIL_UNLESS(results[0].stat == sys_fileStat(paths[0]))
+    `FAIL_UNLESS(results[2].stat == sys_fileStat(paths[2]))
+    `FAIL_UNLESS_EQUAL(results[0].stat.size, 6)
+    `FAIL_UNLESS_EQUAL(results[2].stat.mode.fType, fTypeDir)
+    `FAIL_UNLESS_EQUAL(results[3].stat.mode.fType, fTypeDir)
+
+    // asLink looks at a symbolic link itself
+    results = sys_fileStatMany(paths, .asLink(1));
+    `FAIL_UNLESS_EQUAL(results[3].err, 0)
+    `FAIL_UNLESS_EQUAL(results[3].stat.mode.fType, fTypeSymLink)
+    `FAIL_UNLESS(results[3].stat == sys_fileStat(paths[3], .asLink(1)))
+
+    paths = {};
+    results = sys_fileStatMany(paths);
+    `FAIL_UNLESS_EQUAL(results.size(), 0)
+
+  `SVTEST_END
+
+  `SVTEST(sys_fileStat_ns_inode_check)
+
+    sys_fileStat_s s, h, y;
+
+    `FAIL_UNLESS_EQUAL($system({"cd ", tree, " && touch -d @1500000000.123456789 x.log && ln x.log hard"}), 0)
+
+    // Times have a nanoseconds part
+    s = sys_fileStat({tree, "/x.log"});
+    `FAIL_UNLESS_EQUAL(s.mtime,   1500000000)
+    `FAIL_UNLESS_EQUAL(s.mtimeNs, 123456789)
+    `FAIL_UNLESS(s.atimeNs >= 0 && s.atimeNs < 1000000000)
+    `FAIL_UNLESS(s.ctimeNs >= 0 && s.ctimeNs < 1000000000)
+
+    // A hard link is the same file; a different file is not
+    h = sys_fileStat({tree, "/hard"});
+    y = sys_fileStat({tree, "/a/y.log"});
+    `FAIL_UNLESS(s.inode != 0)
+    `FAIL_UNLESS_EQUAL(h.inode,  s.inode)
+    `FAIL_UNLESS_EQUAL(h.device, s.device)
+    `FAIL_UNLESS_EQUAL(h.mtimeNs, 123456789)
+    `FAIL_UNLESS(y.inode != s.inode)
+    `FAIL_UNLESS_EQUAL(y.device, s.device)
+
+  `SVTEST_END
+
+  `SVTEST(sys_clock_check)
+
+    longint t0, t1;
+    sys_clock_enum clocks[$] = '{sysCLOCK_REALTIME, sysCLOCK_MONOTONIC,
+                                  sysCLOCK_THREAD_CPU, sysCLOCK_PROCESS_CPU};
+
+    foreach (clocks[i]) begin
+      `FAIL_UNLESS(sys_clockNsResolution(clocks[i]) > 0)
+      t0 = sys_clockNsTime(clocks[i]);
+      t1 = sys_clockNsTime(clocks[i]);
+      `FAIL_UNLESS(t0 > 0)
+      `FAIL_UNLESS(t1 >= t0)
+    end
+
+    // The monotonic clock is the default, and never goes backwards
+    t0 = sys_clockNsTime();
+    repeat (1000) begin
+      t1 = sys_clockNsTime();
+      `FAIL_UNLESS(t1 >= t0)
+      t0 = t1;
+    end
+
+    // The real-time clock agrees with sys_nsTime
+    t0 = sys_nsTime();
+    t1 = sys_clockNsTime(sysCLOCK_REALTIME);
+    `FAIL_UNLESS(t1 >= t0)
+    `FAIL_UNLESS(t1 - t0 < 1000000000)
+
+  `SVTEST_END
+
+  `SVTEST(ProfRegion_record_check)
+
+    ProfRegion pr;
+    longint    buckets[64];
+
+    // Regions live for the whole simulation, so each test uses its own names
+    pr = ProfRegion::get("Sys_pkg_unit_test.record");
+    `FAIL_UNLESS(ProfRegion::get("Sys_pkg_unit_test.record", sysCLOCK_PROCESS_CPU) == pr)
+    `FAIL_UNLESS_STR_EQUAL(pr.getName(), "Sys_pkg_unit_test.record")
+    `FAIL_UNLESS_EQUAL(pr.getClock(), sysCLOCK_MONOTONIC)
+    `FAIL_UNLESS(ProfRegion::get("Sys_pkg_unit_test.other") != pr)
+
+    `FAIL_UNLESS_EQUAL(pr.count(), 0)
+    `FAIL_UNLESS(pr.meanNs() == 0.0)
+    pr.record(100);
+    pr.record(300);
+    pr.record(0);
+    `FAIL_UNLESS_EQUAL(pr.count(),   3)
+    `FAIL_UNLESS_EQUAL(pr.totalNs(), 400)
+    `FAIL_UNLESS_EQUAL(pr.minNs(),   0)
+    `FAIL_UNLESS_EQUAL(pr.maxNs(),   300)
+    `FAIL_UNLESS(pr.meanNs() > 133.3 && pr.meanNs() < 133.4)
+
+    // Buckets are powers of 2, with 0 ns counted in the first
+    pr.histogram(buckets);
+    foreach (buckets[k]) begin
+      `FAIL_UNLESS_EQUAL(buckets[k], (k == 0 || k == 6 || k == 8) ? 1 : 0)
+    end
+
+    // Negative durations count as 0
+    pr.record(-5);
+    `FAIL_UNLESS_EQUAL(pr.count(), 4)
+    `FAIL_UNLESS_EQUAL(pr.minNs(), 0)
+    pr.histogram(buckets);
+    `FAIL_UNLESS_EQUAL(buckets[0], 2)
+
+    pr.reset();
+    `FAIL_UNLESS_EQUAL(pr.count(),   0)
+    `FAIL_UNLESS_EQUAL(pr.totalNs(), 0)
+    `FAIL_UNLESS_EQUAL(pr.maxNs(),   0)
+    pr.histogram(buckets);
+    foreach (buckets[k]) begin
+      `FAIL_UNLESS_EQUAL(buckets[k], 0)
+    end
+
+  `SVTEST_END
+
+  `SVTEST(ProfRegion_start_stop_check)
+
+    ProfRegion pr;
+    longint    inner, outer;
+
+    pr = ProfRegion::get("Sys_pkg_unit_test.nested");
+
+    // Each stop() matches the most recent unmatched start()
+    pr.start();
+    pr.start();
+    repeat (1000) void'(sys_clockNsTime());
+    inner = pr.stop();
+    outer = pr.stop();
+    `FAIL_UNLESS(inner >= 0)
+    `FAIL_UNLESS(outer >= inner)
+    `FAIL_UNLESS_EQUAL(pr.count(),   2)
+    `FAIL_UNLESS_EQUAL(pr.totalNs(), inner + outer)
+    `FAIL_UNLESS_EQUAL(pr.maxNs(),   outer)
+
+    // An unmatched stop() is an error and records nothing
+    error_userHandling(1);
+    `FAIL_UNLESS_EQUAL(pr.stop(), 0)
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+    `FAIL_UNLESS_EQUAL(pr.count(), 2)
+
+    // A reset keeps a region that has been started open
+    pr.start();
+    pr.reset();
+    void'(pr.stop());
+    `FAIL_UNLESS_EQUAL(pr.count(), 1)
+
+  `SVTEST_END
+
+  `SVTEST(sys_profDump_check)
+
+    ProfRegion pr, other;
+    string     fname;
+
+    pr    = ProfRegion::get("Sys_pkg_unit_test.dump", sysCLOCK_THREAD_CPU);
+    other = ProfRegion::get("Sys_pkg_unit_test.dumpOther");
+    fname = {tree, "/profile.txt"};
+
+    pr.reset();
+    pr.record(100);
+    pr.record(300);
+    pr.record(0);
+    other.record(7);
+
+    sys_profDump(fname);
+    `FAIL_UNLESS_EQUAL($system({"grep -qx '# svlib profile: [0-9]* regions' ", fname}), 0)
+    `FAIL_UNLESS_EQUAL($system({"grep -qxF 'Sys_pkg_unit_test.dump THREADCPU 3 400 0 300 133' ", fname}), 0)
+    `FAIL_UNLESS_EQUAL($system({"grep -A1 -xF 'Sys_pkg_unit_test.dump THREADCPU 3 400 0 300 133' ", fname,
+                                " | grep -qxF '#   histogram 2^0:1 2^6:1 2^8:1'"}), 0)
+    `FAIL_UNLESS_EQUAL($system({"grep -qxF 'Sys_pkg_unit_test.dumpOther MONOTONIC 1 7 7 7 7' ", fname}), 0)
+
+    // Appending adds a second report
+    sys_profDump(fname, .append(1));
+    `FAIL_UNLESS_EQUAL($system({"test $(grep -c '^# svlib profile:' ", fname, ") -eq 2"}), 0)
+
+    // sys_profReset clears every region
+    sys_profReset();
+    `FAIL_UNLESS_EQUAL(pr.count(),    0)
+    `FAIL_UNLESS_EQUAL(other.count(), 0)
+    sys_profDump(fname);
+    `FAIL_UNLESS_EQUAL($system({"grep -qxF 'Sys_pkg_unit_test.dump THREADCPU 0 0 0 0 0' ", fname}), 0)
+
+    // A file that cannot be written is an error
+    error_userHandling(1);
+    sys_profDump({tree, "/missing/profile.txt"});
+    `FAIL_UNLESS(error_getLast() != 0)
+    error_userHandling(0);
+
+  `SVTEST_END
+
+  `SVUNIT_TESTS_END
+
+endmodule
@@ -0,0 +1,38 @@
+/*
+ * Minimal stand-in for a simulator's svdpi.h, so that svlib_dpi.c can be
+ * built into a plain C test program. Open arrays are svlibTestArray_s,
+ * one-dimensional and ascending (left <= right), as svlib always uses them.
+ */
+#ifndef SVLIB_TEST_SVDPI_H
+#define SVLIB_TEST_SVDPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+  void   *data;
+  int     left, right;
+  size_t  elemSize;
+} svlibTestArray_s;
+
+typedef void *svOpenArrayHandle;
+
+typedef struct { uint32_t aval, bval; } svLogicVecVal;
+
+static inline int svDimensions(const svOpenArrayHandle h) { (void)h; return 1; }
+static inline int svLeft (const svOpenArrayHandle h, int d) { (void)d; return ((svlibTestArray_s*)h)->left;  }
+static inline int svRight(const svOpenArrayHandle h, int d) { (void)d; return ((svlibTestArray_s*)h)->right; }
+static inline int svLow  (const svOpenArrayHandle h, int d) { return svLeft(h, d);  }
+static inline int svHigh (const svOpenArrayHandle h, int d) { return svRight(h, d); }
+static inline int svIncrement(const svOpenArrayHandle h, int d) { (void)h; (void)d; return -1; }
+static inline int svSize (const svOpenArrayHandle h, int d) { return svRight(h, d) - svLeft(h, d) + 1; }
+static inline int svSizeOfArray(const svOpenArrayHandle h) {
+  return svSize(h, 1) * ((svlibTestArray_s*)h)->elemSize;
+}
+static inline void *svGetArrayPtr(const svOpenArrayHandle h) { return ((svlibTestArray_s*)h)->data; }
+static inline void *svGetArrElemPtr1(const svOpenArrayHandle h, int i) {
+  svlibTestArray_s *a = (svlibTestArray_s*)h;
+  return (char*)a->data + (size_t)(i - a->left) * a->elemSize;
+}
+
+#endif
@@ -0,0 +1,10 @@
+/*
+ * Minimal stand-in for a simulator's veriuser.h: just io_printf.
+ */
+#ifndef SVLIB_TEST_VERIUSER_H
+#define SVLIB_TEST_VERIUSER_H
+
+#include <stdio.h>
+#define io_printf printf
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * Minimal stand-in for a simulator's vpi_user.h: just vpi_get_vlog_info,
+ * which the test program provides.
+ */
+#ifndef SVLIB_TEST_VPI_USER_H
+#define SVLIB_TEST_VPI_USER_H
+
+typedef int  PLI_INT32;
+typedef char PLI_BYTE8;
+
+typedef struct t_vpi_vlog_info {
+  PLI_INT32   argc;
+  PLI_BYTE8 **argv;
+  PLI_BYTE8  *product;
+  PLI_BYTE8  *version;
+} s_vpi_vlog_info, *p_vpi_vlog_info;
+
+extern PLI_INT32 vpi_get_vlog_info(p_vpi_vlog_info vlog_info_p);
+
+#endif
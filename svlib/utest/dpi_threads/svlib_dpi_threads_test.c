@@ -0,0 +1,306 @@
+/*=============================================================================
+ *  @brief Stress test: svlib DPI functions called from many threads at once
+ *  @author Jonathan Bromley, Verilab (www.verilab.com)
+ * =============================================================================
+ *
+ *                      svlib SystemVerilog Utilities Library
+ *
+ * @File: svlib_dpi_threads_test.c
+ *
+ * Copyright 2014 Verilab, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ * =============================================================================
+ *
+ * A multi-threaded simulator may call svlib's DPI functions from several
+ * threads at once. Each thread here calls them in a tight loop, with
+ * arguments unique to the thread and iteration, and checks every result
+ * before its next call; a string result overwritten by another thread,
+ * or a corrupted regex cache, shows up as a mismatch. The threads use
+ * more distinct REs than the regex cache holds, so that slots are
+ * recycled while other threads are running them.
+ *
+ * Build and run with "make threads" in utest/. The program prints the
+ * number of failures and exits with status 1 if there were any.
+ *=============================================================================*/
+
+#define _XOPEN_SOURCE 600
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "svdpi.h"
+#include "vpi_user.h"
+
+#define N_THREADS    8
+#define N_ITERATIONS 2000
+#define N_PATTERNS   16   /* per thread; N_THREADS*N_PATTERNS > regex cache size */
+#define TEST_UMASK   022  /* set for the whole run; fileWriteAll must not change it */
+
+extern const char* svlib_dpi_imported_getCErrStr(int32_t errnum);
+extern int32_t     svlib_dpi_imported_getcwd(char **result);
+extern int32_t     svlib_dpi_imported_timeFormat(int64_t epochSeconds, const char *format, const char **formatted);
+extern const char* svlib_dpi_imported_regexErrorString(int32_t err, const char *re);
+extern uint32_t    svlib_dpi_imported_regexRun(const char *re, const char *str, int32_t options,
+                       int32_t startPos, void **hnd, int32_t *key,
+                       int32_t *matchCount, svOpenArrayHandle matchList);
+extern int32_t     svlib_dpi_imported_regexSubst(const char *re, int32_t options, void **hnd,
+                       int32_t *key, const char *str, const char *substStr, int32_t startPos,
+                       int32_t global, const char **result, int32_t *count,
+                       int32_t *matchCount, svOpenArrayHandle matchList);
+extern int32_t     svlib_dpi_imported_regexSplit(const char *re, int32_t options, void **hnd,
+                       int32_t *key, const char *str, int32_t limit, void **fields);
+extern void        svlib_dpi_imported_regexCacheStats(int64_t *hits, int64_t *misses,
+                       int64_t *evictions, int32_t *entries, int32_t *capacity);
+extern int32_t     svlib_dpi_imported_saBufNext(void **h, const char **s);
+extern int32_t     svlib_dpi_imported_strStrip(const char *s, const char *chars, const char **result);
+extern const char* svlib_dpi_imported_yamlQuote(const char *s, int32_t isKey);
+extern int32_t     svlib_dpi_imported_fileReadAll(const char *path, const char **contents);
+extern int32_t     svlib_dpi_imported_fileWriteAll(const char *path, const char *contents, int32_t append);
+extern void *      svlib_dpi_imported_getVlogInfo(char **product, char **version);
+extern const char* svlib_dpi_imported_getVlogInfoNext(void **hnd);
+extern int32_t     svlib_dpi_imported_profCreate(const char *name, int32_t clock, int32_t *id);
+extern int32_t     svlib_dpi_imported_profRecord(int32_t id, int64_t ns);
+extern int32_t     svlib_dpi_imported_pathSplit(const char *path, const svOpenArrayHandle ids,
+                                                int32_t *n, int32_t *absolute);
+extern int32_t     svlib_dpi_imported_pathNormalize(const svOpenArrayHandle ids, int32_t absolute);
+extern const char* svlib_dpi_imported_pathJoin(const svOpenArrayHandle ids, int32_t first, int32_t last);
+extern int32_t     svlib_dpi_imported_profStats(int32_t id, int64_t *stats, int64_t *hist);
+
+/*
+ * Command line for vpi_get_vlog_info, with a nested -f file:
+ *   sim +a=1 -f file.f(+inner=2 +inner=3) +b
+ * which getVlogInfoNext flattens to 5 arguments.
+ */
+static char *fileArgs[] = {"file.f", "+inner=2", "+inner=3", NULL};
+static char *cmdArgs[]  = {"sim", "+a=1", "-f", (char*)fileArgs, "+b", NULL};
+#define N_FLAT_ARGS 5
+
+PLI_INT32 vpi_get_vlog_info(p_vpi_vlog_info p) {
+  p->argc    = 5;
+  p->argv    = cmdArgs;
+  p->product = "svlib_dpi_threads_test";
+  p->version = "1";
+  return 1;
+}
+
+static const int errCodes[] = {ENOENT, EACCES, EINVAL, ENOMEM, EEXIST};
+#define N_ERR_CODES ((int)(sizeof(errCodes)/sizeof(errCodes[0])))
+static char  errStrings[N_ERR_CODES][256];
+static char  cwd[4096];
+static int   profId;
+
+static pthread_mutex_t failLock = PTHREAD_MUTEX_INITIALIZER;
+static int             failures = 0;
+
+static void fail(int t, int i, const char *what, const char *got, const char *expected) {
+  pthread_mutex_lock(&failLock);
+  if (failures < 20) {
+    printf("thread %d iteration %d: %s gave \"%s\", expected \"%s\"\n",
+           t, i, what, got ? got : "(null)", expected ? expected : "(null)");
+  }
+  failures++;
+  pthread_mutex_unlock(&failLock);
+}
+
+static void check(int t, int i, const char *what, const char *got, const char *expected) {
+  if ((got == NULL) || (expected == NULL) || strcmp(got, expected)) fail(t, i, what, got, expected);
+}
+
+static void *worker(void *arg) {
+  int         t = (int)(intptr_t)arg;
+  void       *hnd[N_PATTERNS] = {NULL};
+  int32_t     key[N_PATTERNS] = {0};
+  void       *substHnd = NULL, *splitHnd = NULL;
+  int32_t     substKey = 0,     splitKey = 0;
+  int32_t     matches[4];
+  svlibTestArray_s matchList = {matches, 0, 3, sizeof(int32_t)};
+  int32_t     pathIds[32];
+  svlibTestArray_s pathIdList = {pathIds, 0, 31, sizeof(int32_t)};
+  char        path[64], newPath[64], contents[64];
+  char        re[64], str[64], expected[256];
+  const char *result;
+  char       *mutableResult;
+  int         i;
+
+  snprintf(path, sizeof(path), "svlib_threads_%d.tmp", t);
+  snprintf(newPath, sizeof(newPath), "svlib_threads_%d_new.tmp", t);
+  snprintf(contents, sizeof(contents), "contents of thread %d\n", t);
+  svlib_dpi_imported_fileWriteAll(path, contents, 0);
+
+  for (i=0; i<N_ITERATIONS; i++) {
+    int32_t matchCount, count, err;
+    int     p = i % N_PATTERNS;
+    int     n;
+
+    /* strerror results */
+    n = (t + i) % N_ERR_CODES;
+    check(t, i, "getCErrStr", svlib_dpi_imported_getCErrStr(errCodes[n]), errStrings[n]);
+
+    /* libStringBuffer users */
+    svlib_dpi_imported_getcwd(&mutableResult);
+    check(t, i, "getcwd", mutableResult, cwd);
+    {
+      time_t    when = (time_t)t * 86400 * 37 + i * 61;
+      struct tm parts;
+      localtime_r(&when, &parts);
+      strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", &parts);
+      svlib_dpi_imported_timeFormat(when, "%Y-%m-%d %H:%M:%S", &result);
+      check(t, i, "timeFormat", result, expected);
+    }
+    if ((i % 50) == 0) {
+      result = svlib_dpi_imported_regexErrorString(0, "(unclosed");
+      if ((result == NULL) || (strlen(result) == 0)) fail(t, i, "regexErrorString", result, "an error");
+    }
+
+    /* regex cache, with slots recycled under the other threads' feet */
+    snprintf(re,  sizeof(re),  "^t%dp%d_([0-9]+)$", t, p);
+    snprintf(str, sizeof(str), "t%dp%d_%d", t, p, i);
+    err = svlib_dpi_imported_regexRun(re, str, 0, 0, &hnd[p], &key[p], &matchCount, &matchList);
+    if (err || (matchCount != 2) || (matches[2] != (int32_t)(strchr(str, '_') - str + 1))
+            || (matches[3] != (int32_t)strlen(str))) {
+      fail(t, i, "regexRun", str, re);
+    }
+
+    snprintf(str, sizeof(str), "a%d b%d", t, i);
+    snprintf(expected, sizeof(expected), "a<%d> b<%d>", t, i);
+    err = svlib_dpi_imported_regexSubst("[0-9]+", 0, &substHnd, &substKey, str, "<$0>", 0, 1,
+                                        &result, &count, &matchCount, &matchList);
+    if (err || (count != 2)) fail(t, i, "regexSubst count", str, expected);
+    check(t, i, "regexSubst", result, expected);
+
+    {
+      void *fields;
+      char  field[16];
+      int   f = 0;
+      snprintf(str, sizeof(str), "%d, %d ,x", t, i);
+      err = svlib_dpi_imported_regexSplit(" *, *", 0, &splitHnd, &splitKey, str, 0, &fields);
+      if (err) fail(t, i, "regexSplit", str, "no error");
+      while (!err && fields != NULL) {
+        svlib_dpi_imported_saBufNext(&fields, &result);
+        if (result == NULL) break;
+        switch (f++) {
+          case 0:  snprintf(field, sizeof(field), "%d", t); break;
+          case 1:  snprintf(field, sizeof(field), "%d", i); break;
+          default: snprintf(field, sizeof(field), "x");     break;
+        }
+        check(t, i, "regexSplit field", result, field);
+      }
+      if (f != 3) fail(t, i, "regexSplit field count", str, "3 fields");
+    }
+
+    /* other per-call results */
+    snprintf(str, sizeof(str), "  t%d-i%d  ", t, i);
+    snprintf(expected, sizeof(expected), "t%d-i%d", t, i);
+    svlib_dpi_imported_strStrip(str, " ", &result);
+    check(t, i, "strStrip", result, expected);
+
+    snprintf(str, sizeof(str), "key: t%d-i%d", t, i);
+    result = svlib_dpi_imported_yamlQuote(str, 0);
+    if ((result == NULL) || (strstr(result, expected) == NULL)) fail(t, i, "yamlQuote", result, str);
+
+    /* Pathname components are interned in a table shared by all threads */
+    {
+      int32_t n, absolute;
+      snprintf(str, sizeof(str), "/work/t%d/./i%d/../run%d.log", t, i, i % 7);
+      snprintf(expected, sizeof(expected), "work/t%d/run%d.log", t, i % 7);
+      pathIdList.right = 31;
+      err = svlib_dpi_imported_pathSplit(str, &pathIdList, &n, &absolute);
+      if (err || !absolute) fail(t, i, "pathSplit", str, "absolute path");
+      pathIdList.right = n - 1;
+      pathIdList.right = svlib_dpi_imported_pathNormalize(&pathIdList, absolute) - 1;
+      check(t, i, "pathJoin", svlib_dpi_imported_pathJoin(&pathIdList, 0, pathIdList.right), expected);
+    }
+
+    if ((i % 10) == 0) {
+      err = svlib_dpi_imported_fileReadAll(path, &result);
+      if (err) fail(t, i, "fileReadAll", strerror(err), "no error");
+      else     check(t, i, "fileReadAll", result, contents);
+
+      /* A new file must get 0666 less the umask set in main() */
+      {
+        struct stat st;
+        unlink(newPath);
+        err = svlib_dpi_imported_fileWriteAll(newPath, contents, 0);
+        if (err) fail(t, i, "fileWriteAll", strerror(err), "no error");
+        else if (stat(newPath, &st)) fail(t, i, "fileWriteAll", strerror(errno), "new file");
+        else if ((st.st_mode & 07777) != (0666 & ~TEST_UMASK)) {
+          snprintf(expected, sizeof(expected), "%o", 0666 & ~TEST_UMASK);
+          snprintf(str, sizeof(str), "%o", (unsigned)(st.st_mode & 07777));
+          fail(t, i, "fileWriteAll mode", str, expected);
+        }
+      }
+    }
+
+    /* command-line walk */
+    if ((i % 100) == 0) {
+      char *product, *version;
+      void *vlog = svlib_dpi_imported_getVlogInfo(&product, &version);
+      int   nArgs = 0;
+      while (svlib_dpi_imported_getVlogInfoNext(&vlog) != NULL) nArgs++;
+      if (nArgs != N_FLAT_ARGS) fail(t, i, "getVlogInfoNext", "wrong number of arguments", "5");
+    }
+
+    svlib_dpi_imported_profRecord(profId, i);
+  }
+
+  unlink(path);
+  unlink(newPath);
+  return NULL;
+}
+
+int main(void) {
+  pthread_t threads[N_THREADS];
+  int64_t   stats[8], hist[64];
+  int64_t   hits, misses, evictions;
+  int32_t   entries, capacity;
+  int       t;
+
+  for (t=0; t<N_ERR_CODES; t++) {
+    strncpy(errStrings[t], strerror(errCodes[t]), sizeof(errStrings[t])-1);
+  }
+  if (getcwd(cwd, sizeof(cwd)) == NULL) {
+    perror("getcwd");
+    return 1;
+  }
+  svlib_dpi_imported_profCreate("threads", 1, &profId);
+  umask(TEST_UMASK);
+
+  for (t=0; t<N_THREADS; t++) {
+    pthread_create(&threads[t], NULL, worker, (void*)(intptr_t)t);
+  }
+  for (t=0; t<N_THREADS; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  if (umask(TEST_UMASK) != TEST_UMASK) {
+    printf("umask was changed while the threads ran\n");
+    failures++;
+  }
+  svlib_dpi_imported_profStats(profId, stats, hist);
+  if (stats[0] != (int64_t)N_THREADS * N_ITERATIONS) {
+    printf("profRecord: count is %lld, expected %d\n", (long long)stats[0], N_THREADS * N_ITERATIONS);
+    failures++;
+  }
+  svlib_dpi_imported_regexCacheStats(&hits, &misses, &evictions, &entries, &capacity);
+  printf("regex cache: %lld hits, %lld misses, %lld evictions, %d/%d entries\n",
+         (long long)hits, (long long)misses, (long long)evictions, entries, capacity);
+  printf("%d threads x %d iterations: %d failures\n", N_THREADS, N_ITERATIONS, failures);
+  return failures ? 1 : 0;
+}